@@ -0,0 +1,233 @@
+// Scene description and density model shared by the cloud passes.
+// Included after #version; callers declare their own inputs and outputs.
+
+// ========== Uniforms ==========
+// Scene data, uploaded by SceneUploader when the scene changes (std140, mirrored by SceneBlockData)
+layout(std140) uniform SceneBlock {
+    // Bounding sphere information (used to determine the volumetric rendering region)
+    vec3 uBoundingSphereCenter;
+    float uBoundingSphereRadius;
+
+    // Number of cloud spheres in uSphereBuffer
+    int uSphereCount;
+
+    // Box covered by uSdfVolume and its largest voxel edge
+    vec3 uSdfBoundsMin;
+    float uSdfVoxel;
+    vec3 uSdfBoundsMax;
+    // How far the spheres may have moved since uSdfVolume was baked; 0 for a static scene
+    float uSdfStaleness;
+
+    // Unit vector pointing towards the light
+    vec3 uLightDir;
+
+    // Samples per ray: fixed march (the adaptive march takes twice as many) and shadow march
+    int uMarchSteps;
+    int uShadowSteps;
+
+    // Weights of the uNoiseTex channels: (1, 0, 0, 0) for a single channel, the octave
+    // weights when the channels hold four octaves (Noise::Format::RGBA8Octaves)
+    vec4 uNoiseWeights;
+};
+
+// Per-frame data, written into a ring of buffer slices (std140, mirrored by FrameBlockData)
+layout(std140) uniform FrameBlock {
+    vec2 iResolution;                // Screen resolution (can be retained or removed if unnecessary)
+    float iTime;                     // Time variable for controlling rotation
+
+    // Camera (Camera.h): position, orthonormal view axes and the tangents of the half field of view
+    vec3 uCameraPosition;
+    float uCameraDepthRange;         // Distance written as depth 1 to the cloud pass alpha
+    vec3 uCameraForward;
+    float uCameraTanHalfFovX;
+    vec3 uCameraRight;
+    float uCameraTanHalfFovY;
+    vec3 uCameraUp;
+};
+
+// Static noise texture (uploaded from C++ and generated using Perlin noise)
+uniform sampler2D uNoiseTex;
+
+// Tileable Perlin-Worley volume (R = base shape, GBA = Worley detail octaves)
+uniform sampler3D uNoiseVolume;
+uniform bool uUseNoiseVolume;
+
+// Cloud spheres as vec4(x, y, z, r), ordered so every BVH leaf covers a contiguous run
+uniform samplerBuffer uSphereBuffer;
+// Flattened BVH built by SphereBVH, two texels per node:
+//   texel 0 = (boundsMin, leftOrFirst), texel 1 = (boundsMax, count)
+// Leaves have count > 0; interior nodes store -(split axis + 1), their left child follows them
+uniform samplerBuffer uBvhNodes;
+
+// Signed distance to the sphere union baked over the cloud's box (SdfVolume)
+uniform sampler3D uSdfVolume;
+uniform bool uUseSdfVolume;
+
+// ========== Specialization ==========
+// A program built with CLOUD_* defines (Shader::Defines, ShaderPermutations) has those
+// settings folded in as constants, so the compiler drops the branches and gets fixed
+// loop bounds; without them the uniforms decide at run time
+#ifdef CLOUD_NOISE_VOLUME
+#define USE_NOISE_VOLUME (CLOUD_NOISE_VOLUME != 0)
+#else
+#define USE_NOISE_VOLUME uUseNoiseVolume
+#endif
+#ifdef CLOUD_SDF_VOLUME
+#define USE_SDF_VOLUME (CLOUD_SDF_VOLUME != 0)
+#else
+#define USE_SDF_VOLUME uUseSdfVolume
+#endif
+#ifdef CLOUD_MARCH_STEPS
+#define MARCH_STEPS CLOUD_MARCH_STEPS
+#else
+#define MARCH_STEPS uMarchSteps
+#endif
+#ifdef CLOUD_SHADOW_STEPS
+#define SHADOW_STEPS CLOUD_SHADOW_STEPS
+#else
+#define SHADOW_STEPS uShadowSteps
+#endif
+
+// ========== Signed Distance Function (SDF) for Cloud Volume ==========
+// Distance from p to an axis-aligned box (0 inside); a lower bound for every sphere it contains
+float boxDistance(vec3 p, vec3 boxMin, vec3 boxMax)
+{
+    vec3 q = max(max(boxMin - p, p - boxMax), 0.0);
+    return length(q);
+}
+
+// If the return value < 0, the point p is inside at least one sphere.
+// Outside the cloud the distance is exact; inside, the first containing sphere ends the
+// search, so the negative value is not necessarily the deepest one.
+float sdCloud(vec3 p)
+{
+    float d = 1e6;
+    if (uSphereCount == 0)
+    return d;
+
+    // Depth must match SphereBVH::kMaxDepth
+    int stack[32];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int node = stack[--top];
+        vec4 lo = texelFetch(uBvhNodes, node * 2);
+        vec4 hi = texelFetch(uBvhNodes, node * 2 + 1);
+        // Nothing below this node can be closer than the current best
+        if (boxDistance(p, lo.xyz, hi.xyz) >= d)
+        continue;
+
+        int count = int(hi.w);
+        if (count > 0) {
+            int first = int(lo.w);
+            for (int i = 0; i < count; i++) {
+                vec4 s = texelFetch(uSphereBuffer, first + i);
+                d = min(d, length(p - s.xyz) - s.w);
+            }
+            if (d < 0.0)
+            return d;
+        } else {
+            // Visit the child on p's side of the split first so the far one is more likely pruned
+            int axis = -count - 1;
+            int left = node + 1;
+            int right = int(lo.w);
+            bool leftFirst = p[axis] < 0.5 * (lo[axis] + hi[axis]);
+            stack[top++] = leftFirst ? right : left;
+            stack[top++] = leftFirst ? left : right;
+        }
+    }
+    return d;
+}
+
+// Baked distance: one fetch inside the box. Outside it the box is padded by empty voxels,
+// so the distance to the box plus one voxel is still a lower bound.
+float sdCloudBaked(vec3 p)
+{
+    float outside = boxDistance(p, uSdfBoundsMin, uSdfBoundsMax);
+    if (outside > 0.0)
+    return outside + uSdfVoxel;
+    vec3 uvw = (p - uSdfBoundsMin) / (uSdfBoundsMax - uSdfBoundsMin);
+    return texture(uSdfVolume, uvw).r;
+}
+
+// Distance to the cloud from the baked volume or the BVH; < 0 means inside. While the
+// spheres move the bake lags behind them, so it only rules out space that is certainly
+// empty; anywhere closer, the refit BVH decides the distance and the sign.
+float cloudDistance(vec3 p)
+{
+    if (!USE_SDF_VOLUME)
+    return sdCloud(p);
+    float baked = sdCloudBaked(p);
+    if (uSdfStaleness > 0.0 && baked - uSdfVoxel - uSdfStaleness <= 0.0)
+    return sdCloud(p);
+    return baked;
+}
+
+// Distance along a ray that is certainly empty: the baked volume is trilinearly
+// interpolated, so it can overestimate by up to about one voxel, plus however far the
+// spheres moved since the bake
+float safeDistance(float dist)
+{
+    return USE_SDF_VOLUME ? dist - uSdfVoxel - uSdfStaleness : dist;
+}
+
+// ========== Cloud Interior Density Function ==========
+// Noise density at a point known to be inside the cloud volume, with Y-axis rotation applied
+float noiseDensity(vec3 p)
+{
+    // Compute rotation angle (rotation speed can be adjusted)
+    float angle = iTime * 0.05;
+    float cosA = cos(angle);
+    float sinA = sin(angle);
+
+    // Rotate point p in the XZ plane
+    float rx = p.x * cosA - p.z * sinA;
+    float rz = p.x * sinA + p.z * cosA;
+    vec3 rotatedP = vec3(rx, p.y, rz);
+
+    float noiseVal;
+    if (USE_NOISE_VOLUME) {
+        // One 3D fetch: erode the Perlin-Worley base shape with the Worley detail octaves
+        vec4 n = texture(uNoiseVolume, rotatedP * 0.1);
+        float detail = dot(n.gba, vec3(0.625, 0.25, 0.125));
+        noiseVal = clamp((n.r - detail * 0.35) / (1.0 - detail * 0.35), 0.0, 1.0);
+    } else {
+        // Sample noise texture (scaling factor 0.1 can be adjusted as needed); one fetch
+        // covers every octave the texture packs
+        noiseVal = dot(texture(uNoiseTex, rotatedP.xz * 0.1), uNoiseWeights);
+    }
+
+    // Apply smoothstep function to create a soft transition effect
+    return smoothstep(0.3, 1.0, noiseVal);
+}
+
+// If p is inside the cloud volume, use noise texture sampling to compute local density
+float cloudDensity(vec3 p)
+{
+    // If the point is not inside any cloud sphere, return a density of 0
+    if (cloudDistance(p) > 0.0)
+    return 0.0;
+    return noiseDensity(p);
+}
+
+// ========== Shadowing ==========
+// Simple shadow calculation: light reaching pos along uLightDir, SHADOW_STEPS samples 0.05 apart
+float shadowAt(vec3 pos)
+{
+    float shadow = 1.0;
+    vec3 lpos = pos;
+    float stepSize = 0.05;
+    for (int s = 0; s < SHADOW_STEPS; s++) {
+        lpos += uLightDir * stepSize;
+        float dCloud = length(lpos - uBoundingSphereCenter) - uBoundingSphereRadius;
+        if (dCloud > 0.0)
+        break;
+        float ds = cloudDensity(lpos);
+        if (ds > 0.02) {
+            shadow *= exp(-ds * 0.3);
+            if (shadow < 0.01)
+            break;
+        }
+    }
+    return shadow;
+}
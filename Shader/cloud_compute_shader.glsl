@@ -0,0 +1,117 @@
+#version 430 core
+
+// Compute version of the cloud pass (ComputeMarcher): one 8x8 work group per screen tile.
+// The first invocation tests the cone through the tile's corner rays against the bounding
+// sphere and the sphere BVH; tiles that cannot reach any sphere skip the march entirely.
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// Written at the cloud pass size, then blitted to the bound framebuffer
+layout(rgba16f, binding = 0) writeonly uniform image2D uOutput;
+
+// Scene uniforms, cloud distance and density
+#include "cloud_common.glsl"
+// Lighting and the march loops
+#include "cloud_march.glsl"
+
+shared bool tileHit;
+
+// Cone from the camera around all rays of a tile
+struct TileCone {
+    vec3 apex;
+    vec3 axis;
+    float halfAngle;
+};
+
+// True if the sphere (c, r) intersects the cone (conservative near the apex)
+bool coneHitsSphere(TileCone cone, vec3 c, float r)
+{
+    vec3 v = c - cone.apex;
+    float d = length(v);
+    if (d <= r)
+    return true;
+    float angle = acos(clamp(dot(v / d, cone.axis), -1.0, 1.0));
+    return angle <= cone.halfAngle + asin(r / d);
+}
+
+// Bounds every ray marched by the tile whose first invocation sits at tileOrigin
+TileCone tileCone(vec2 tileOrigin)
+{
+    vec2 first = marchedPixel(tileOrigin + 0.5);
+    vec2 last = marchedPixel(tileOrigin + vec2(gl_WorkGroupSize.xy) - 0.5);
+    // Rays through a rectangle of pixels lie inside the cone spanned by its corner rays
+    vec3 corners[4] = vec3[4](cameraDirection(first), cameraDirection(vec2(last.x, first.y)),
+                              cameraDirection(vec2(first.x, last.y)), cameraDirection(last));
+    TileCone cone;
+    cone.apex = cameraOrigin();
+    cone.axis = normalize(corners[0] + corners[1] + corners[2] + corners[3]);
+    float minCos = 1.0;
+    for (int i = 0; i < 4; i++)
+    minCos = min(minCos, dot(cone.axis, corners[i]));
+    cone.halfAngle = acos(clamp(minCos, -1.0, 1.0));
+    return cone;
+}
+
+// Walks the sphere BVH with the tile cone, given in the cloud's space; node boxes are tested
+// through their bounding spheres
+bool coneTouchesCloud(TileCone cone)
+{
+    if (!coneHitsSphere(cone, uBoundingSphereCenter, uBoundingSphereRadius))
+    return false;
+
+    // The baked distance is interpolated and can turn negative up to about a voxel outside
+    // the spheres, so grow every sphere by that much when it is in use
+    float margin = USE_SDF_VOLUME ? uSdfVoxel : 0.0;
+
+    // Depth must match SphereBVH::kMaxDepth
+    int stack[32];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int node = stack[--top];
+        vec4 lo = texelFetch(uBvhNodes, node * 2);
+        vec4 hi = texelFetch(uBvhNodes, node * 2 + 1);
+        if (!coneHitsSphere(cone, 0.5 * (lo.xyz + hi.xyz), 0.5 * length(hi.xyz - lo.xyz) + margin))
+        continue;
+
+        int count = int(hi.w);
+        if (count > 0) {
+            int first = int(lo.w);
+            for (int i = 0; i < count; i++) {
+                vec4 s = texelFetch(uSphereBuffer, first + i);
+                if (coneHitsSphere(cone, s.xyz, s.w + margin))
+                return true;
+            }
+        } else {
+            stack[top++] = int(lo.w);
+            stack[top++] = node + 1;
+        }
+    }
+    return false;
+}
+
+// True if the tile cone reaches any instance; a uniform scale keeps the cone's angle
+bool tileTouchesCloud(TileCone cone)
+{
+    if (uSphereCount == 0)
+    return false;
+    for (int i = 0; i < uInstanceCount; i++) {
+        TileCone local = cone;
+        local.apex = (cone.apex - uInstances[i].xyz) / uInstances[i].w;
+        if (coneTouchesCloud(local))
+        return true;
+    }
+    return false;
+}
+
+void main()
+{
+    if (gl_LocalInvocationIndex == 0u)
+    tileHit = tileTouchesCloud(tileCone(vec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy)));
+    barrier();
+
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, imageSize(uOutput))))
+    return;
+    vec4 color = tileHit ? renderCloud(marchedPixel(vec2(texel) + 0.5)) : kBackground;
+    imageStore(uOutput, texel, color);
+}
@@ -0,0 +1,7 @@
+// Cloud instances written by CloudScene: the visible ones, sorted front to back. Each
+// places the shared cloud at offset + scale * p (std140, mirrored by InstanceBlockData).
+const int kMaxInstances = 64;    // CloudScene::kMaxVisible
+layout(std140) uniform InstanceBlock {
+    int uInstanceCount;
+    vec4 uInstances[kMaxInstances];  // xyz = offset, w = scale
+};
@@ -0,0 +1,222 @@
+// Lighting and ray marching shared by the fragment and compute cloud passes.
+// Included after cloud_common.glsl; callers pass the pixel to renderCloud().
+
+// Transmittance towards the light over the uSdfVolume box, baked by LightVolume
+uniform sampler3D uLightVolume;
+uniform bool uUseLightVolume;
+#ifdef CLOUD_LIGHT_VOLUME
+#define USE_LIGHT_VOLUME (CLOUD_LIGHT_VOLUME != 0)
+#else
+#define USE_LIGHT_VOLUME uUseLightVolume
+#endif
+
+// 0 = fixed steps over the whole bounding-sphere chord,
+// 1 = adaptive: sphere-trace empty space, fine fixed steps inside, jittered start
+uniform int uMarchMode;
+#ifdef CLOUD_MARCH_MODE
+#define MARCH_MODE CLOUD_MARCH_MODE
+#else
+#define MARCH_MODE uMarchMode
+#endif
+
+// Temporal accumulation (FramePipeline): the pass runs at 1/cell of the resolution and
+// each invocation marches one pixel of its cell x cell block, picked by uTemporalPhase
+uniform int uTemporalCell;       // 1 = every pixel, 2 = 1/4 of them, 4 = 1/16
+uniform int uTemporalPhase;      // Position within the block marched this frame (x + y * cell)
+uniform int uFrameIndex;         // Varies the start jitter from frame to frame
+
+// Visible cloud instances, front to back; rays are marched in the cloud's own space
+#include "cloud_instances.glsl"
+
+// Pixels whose ray misses the cloud: gray background, nothing hit
+const vec4 kBackground = vec4(0.6, 0.6, 0.6, 1.0);
+
+// ========== Lighting ==========
+// Base cloud color set to white
+const vec3 fogColor = vec3(1.0);
+// Define an orange light source from the upper-right corner
+const vec3 lightColor = vec3(1.0, 0.7, 0.5);
+
+// Scattering and absorption coefficients (adjustable)
+const float sigma_s = 2.0;
+const float sigma_a = 0.2;
+
+// Light reaching pos: one fetch from the baked volume, or the shadow march it was baked from
+float lightAt(vec3 pos)
+{
+    if (USE_LIGHT_VOLUME) {
+        vec3 uvw = (pos - uSdfBoundsMin) / (uSdfBoundsMax - uSdfBoundsMin);
+        return texture(uLightVolume, uvw).r;
+    }
+    return shadowAt(pos);
+}
+
+// Accumulates one sample of length stepLen; returns false once the ray is opaque
+bool integrateSample(vec3 pos, float dens, float stepLen, inout vec3 outColor, inout float transmittance)
+{
+    float shadow = lightAt(pos);
+
+    // Compute scattering: mix white (fogColor) and orange light (lightColor)
+    // The mix parameter 0.3 controls the proportion of the orange component (adjustable)
+    vec3 scattering = mix(fogColor, lightColor, 0.3) * shadow;
+    vec3 stepColor = dens * sigma_s * scattering * transmittance * stepLen;
+    outColor += stepColor;
+
+    // Update transmittance (Beer-Lambert law)
+    float absorb = dens * (sigma_a + sigma_s) * stepLen;
+    transmittance *= exp(-absorb);
+    return transmittance >= 0.001;
+}
+
+// ========== Ray Marching Loops ==========
+// Full-resolution pixel marched by the invocation at fragCoord (a pixel center)
+vec2 marchedPixel(vec2 fragCoord)
+{
+    vec2 offset = vec2(uTemporalPhase % uTemporalCell, uTemporalPhase / uTemporalCell);
+    return floor(fragCoord) * float(uTemporalCell) + offset + 0.5;
+}
+
+// Per-pixel value in [0, 1) with little low-frequency structure (Jimenez 2014)
+float interleavedGradientNoise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+// Start offset of a ray in steps: fixed per pixel, and also varied per frame in temporal
+// mode so that the accumulated history averages several offsets
+float rayJitter(vec2 pixel)
+{
+    if (uTemporalCell > 1)
+    pixel += 5.588238 * float(uFrameIndex % 64);
+    return interleavedGradientNoise(pixel);
+}
+
+// Fixed mode: MARCH_STEPS evenly spaced samples over [tNear, tFar], jittered only in temporal
+// mode; samples inside the distance bound are skipped without moving the remaining ones.
+// Returns the distance of the first dense sample, or tFar if there is none.
+float marchFixed(vec3 ro, vec3 rd, float tNear, float tFar, float jitter, inout vec3 outColor, inout float transmittance)
+{
+    float marchStep = (tFar - tNear) / float(MARCH_STEPS);
+    float tStart = tNear + (uTemporalCell > 1 ? jitter * marchStep : 0.0);
+    float tHit = tFar;
+
+    for (int i = 0; i < MARCH_STEPS; i++) {
+        float tCurrent = tStart + float(i) * marchStep;
+        vec3 pos = ro + rd * tCurrent;
+
+        // Empty-space skipping: every sample closer than the distance bound is outside the cloud
+        float dist = cloudDistance(pos);
+        if (dist > 0.0) {
+            i += max(int(ceil(safeDistance(dist) / marchStep)) - 1, 0);
+            continue;
+        }
+
+        float dens = noiseDensity(pos);
+        if (dens > 0.001) {
+            tHit = min(tHit, tCurrent);
+            if (!integrateSample(pos, dens, marchStep, outColor, transmittance))
+            break;
+        }
+    }
+    return tHit;
+}
+
+// Adaptive mode: sphere-trace with the cloud distance outside the cloud and integrate with
+// steps twice as fine as the fixed mode inside. The start is jittered by up to one step
+// per pixel, which trades the fixed mode's banding for fine grain.
+// Returns the distance of the first dense sample, or tFar if there is none.
+float marchAdaptive(vec3 ro, vec3 rd, float tNear, float tFar, float jitter, inout vec3 outColor, inout float transmittance)
+{
+    int fineSteps = 2 * MARCH_STEPS;
+    int maxIterations = 4 * MARCH_STEPS;
+    float fineStep = (tFar - tNear) / float(fineSteps);
+
+    float t = tNear + fineStep * jitter;
+    float tHit = tFar;
+    for (int i = 0; i < maxIterations && t < tFar; i++) {
+        vec3 pos = ro + rd * t;
+        float dist = cloudDistance(pos);
+        if (dist > 0.0) {
+            // Never advance by less than a fine step, so grazing rays still terminate
+            t += max(safeDistance(dist), fineStep);
+            continue;
+        }
+
+        float dens = noiseDensity(pos);
+        if (dens > 0.001) {
+            tHit = min(tHit, t);
+            if (!integrateSample(pos, dens, fineStep, outColor, transmittance))
+            break;
+        }
+        t += fineStep;
+    }
+    return tHit;
+}
+
+// ========== Camera ==========
+// Camera position, from FrameBlock
+vec3 cameraOrigin()
+{
+    return uCameraPosition;
+}
+
+// Ray direction through a screen pixel, using a simple perspective projection
+vec3 cameraDirection(vec2 pixel)
+{
+    // Map the pixel's screen position to the range [-1, 1]
+    vec2 uv = pixel / iResolution * 2.0 - 1.0;
+    return normalize(uCameraForward + uv.x * uCameraTanHalfFovX * uCameraRight + uv.y * uCameraTanHalfFovY * uCameraUp);
+}
+
+// Chord of a ray through the cloud's bounding sphere, in the cloud's space; false on a miss
+bool boundingChord(vec3 ro, vec3 rd, out float tNear, out float tFar)
+{
+    vec3 oc = ro - uBoundingSphereCenter;
+    float R = uBoundingSphereRadius;
+    float b = dot(oc, rd);
+    float c2 = dot(oc, oc) - R * R;
+    float det = b * b - c2;
+    if (det < 0.0)
+    return false;
+    float sqrtDet = sqrt(det);
+    tNear = max(-b - sqrtDet, 0.0);
+    tFar = -b + sqrtDet;
+    // A negative far end means the whole sphere is behind the camera
+    return tFar >= 0.0;
+}
+
+// Color of one screen pixel, with the depth for the upsample pass in alpha
+vec4 renderCloud(vec2 pixel)
+{
+    vec3 ro = cameraOrigin();
+    vec3 rd = cameraDirection(pixel);
+
+    vec3 outColor = vec3(0.0);
+    float transmittance = 1.0;
+    float jitter = rayJitter(pixel);
+    float tHit = uCameraDepthRange;
+    // Front to back, so the clouds behind an opaque one are never marched
+    for (int i = 0; i < uInstanceCount && transmittance >= 0.001; i++) {
+        vec4 instance = uInstances[i];
+        // A uniform scale leaves the direction alone; distances shrink by instance.w
+        vec3 localOrigin = (ro - instance.xyz) / instance.w;
+        float tNear, tFar;
+        if (!boundingChord(localOrigin, rd, tNear, tFar))
+        continue;
+        float t;
+        if (MARCH_MODE == 1)
+        t = marchAdaptive(localOrigin, rd, tNear, tFar, jitter, outColor, transmittance);
+        else
+        t = marchFixed(localOrigin, rd, tNear, tFar, jitter, outColor, transmittance);
+        if (t < tFar)
+        tHit = min(tHit, t * instance.w);
+    }
+
+    // Final color: blend cloud color with background (gray background)
+    vec3 backgroundColor = vec3(0.6);
+    vec3 finalColor = outColor + backgroundColor * transmittance;
+    // Alpha carries the depth for the upsample pass: the first dense sample over the
+    // camera's depth range, so 1 means nothing was hit
+    float depth = transmittance > 0.999 ? 1.0 : min(tHit / uCameraDepthRange, 1.0);
+    return vec4(finalColor, depth);
+}
@@ -0,0 +1,46 @@
+#version 330 core
+
+// Geometry of the cloud pass (CloudScene::draw): the full-screen triangle, or a box around
+// the bounding sphere of every visible instance, so that only pixels that can see a cloud
+// run the fragment shader
+layout(location = 0) in vec3 aPos;
+out vec2 vTexCoord;
+// Instance whose proxy produced the fragment
+flat out int vInstance;
+
+// Scene and camera uniforms
+#include "cloud_common.glsl"
+// Visible instances, front to back; instance i of the draw is uInstances[i]
+#include "cloud_instances.glsl"
+
+uniform bool uDrawProxies;
+
+// Corners of the 12 box triangles, counter-clockwise seen from outside; corner bit k set = +1 on axis k
+const int kBoxCorners[36] = int[36](4, 6, 2, 4, 2, 0, 1, 3, 7, 1, 7, 5, 1, 5, 4, 1, 4, 0,
+                                    2, 6, 7, 2, 7, 3, 2, 3, 1, 2, 1, 0, 4, 5, 7, 4, 7, 6);
+
+void main()
+{
+    if (!uDrawProxies) {
+        // Map the [-1,1]^2 vertex coordinates to screen space
+        gl_Position = vec4(aPos, 1.0);
+        vTexCoord = aPos.xy * 0.5 + 0.5;
+        vInstance = 0;
+        return;
+    }
+
+    int corner = kBoxCorners[gl_VertexID];
+    vec3 unit = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0;
+    vec4 instance = uInstances[gl_InstanceID];
+    vec3 world = instance.xyz + instance.w * (uBoundingSphereCenter + uBoundingSphereRadius * unit);
+
+    // The projection of cameraDirection(): x and y over the view distance map to uv, and
+    // depth runs from -1 at the near plane towards 1 at infinity
+    vec3 v = world - uCameraPosition;
+    float z = dot(v, uCameraForward);
+    float near = 0.001 * uCameraDepthRange;
+    gl_Position = vec4(dot(v, uCameraRight) / uCameraTanHalfFovX, dot(v, uCameraUp) / uCameraTanHalfFovY, z - 2.0 * near, z);
+    // The cloud pass works from gl_FragCoord
+    vTexCoord = vec2(0.0);
+    vInstance = gl_InstanceID;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// Bakes one z slice of the light volume: every fragment is a texel center in the
+// uSdfVolume box, and its value is the shadow march towards the light from there
+out float FragTransmittance;
+
+// Scene uniforms, cloud distance and density
+#include "cloud_common.glsl"
+
+uniform int uSlice;
+uniform int uVolumeSize;
+
+void main()
+{
+    vec3 texel = vec3(gl_FragCoord.xy, float(uSlice) + 0.5) / float(uVolumeSize);
+    vec3 pos = uSdfBoundsMin + texel * (uSdfBoundsMax - uSdfBoundsMin);
+    FragTransmittance = shadowAt(pos);
+}
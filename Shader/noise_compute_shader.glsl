@@ -0,0 +1,227 @@
+#version 430 core
+
+// GPU backend of the noise generators (GpuNoise): the permutation-based Perlin and Worley
+// noise of Noise.cpp, in double precision and with the same operations in the same order,
+// so the texels match the CPU reference. With NOISE_VOLUME the RGBA Perlin-Worley volume
+// of Noise::generatePerlinWorleyVolume is written, otherwise the 2D texture of
+// Noise::generatePerlinNoiseTexture. Results are `precise` so no multiply-add is fused.
+#ifdef NOISE_VOLUME
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+layout(rgba8, binding = 0) writeonly uniform image3D uTarget;
+#else
+layout(local_size_x = 8, local_size_y = 8) in;
+layout(r8, binding = 0) writeonly uniform image2D uTarget;
+#endif
+
+// PerlinNoise::permutation(): 512 entries, the shuffled 0..255 twice
+uniform usamplerBuffer uPermutation;
+uniform int uWidth;
+uniform int uHeight;
+uniform int uDepth;
+// 2D texture: lattice cells across the texture (Noise::kTextureFrequency)
+uniform float uFrequency;
+// Volume: NoiseVolumeParams and the Worley seed (Noise::worleySeed)
+uniform int uBaseFrequency;
+uniform int uOctaves;
+uniform float uGain;
+uniform int uWorleySeed;
+
+int perm(int i)
+{
+    return int(texelFetch(uPermutation, i).r);
+}
+
+double fade(double t)
+{
+    precise double r = t * t * t * (t * (t * 6.0LF - 15.0LF) + 10.0LF);
+    return r;
+}
+
+double lerpD(double t, double a, double b)
+{
+    precise double r = a + t * (b - a);
+    return r;
+}
+
+double grad(int hash, double x, double y)
+{
+    int h = hash & 7;
+    double u = h < 4 ? x : y;
+    double v = h < 4 ? y : x;
+    precise double r = ((h & 1) != 0 ? -u : u) + ((h & 2) != 0 ? -v : v);
+    return r;
+}
+
+double grad(int hash, double x, double y, double z)
+{
+    int h = hash & 15;
+    double u = h < 8 ? x : y;
+    double v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    precise double r = ((h & 1) != 0 ? -u : u) + ((h & 2) != 0 ? -v : v);
+    return r;
+}
+
+// Positive modulo; GLSL leaves % undefined for negative operands
+int wrapCell(int i, int period)
+{
+    return i >= 0 ? i % period : (period - 1) - ((-i - 1) % period);
+}
+
+#ifndef NOISE_VOLUME
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (texel.x >= uWidth || texel.y >= uHeight)
+    return;
+
+    precise double frequency = double(uFrequency);
+    precise double x = double(texel.x) / double(uWidth) * frequency;
+    precise double y = double(texel.y) / double(uHeight) * frequency;
+    double fx = floor(x);
+    double fy = floor(y);
+    int X = int(fx) & 255;
+    int Y = int(fy) & 255;
+    precise double xf = x - fx;
+    precise double yf = y - fy;
+    double u = fade(xf);
+    double v = fade(yf);
+    int A = perm(X) + Y;
+    int B = perm(X + 1) + Y;
+    precise double res = lerpD(v,
+                               lerpD(u, grad(perm(A), xf, yf),
+                                        grad(perm(B), xf - 1.0LF, yf)),
+                               lerpD(u, grad(perm(A + 1), xf, yf - 1.0LF),
+                                        grad(perm(B + 1), xf - 1.0LF, yf - 1.0LF)));
+
+    // Same byte as toByte() in Noise.cpp: truncated, then stored exactly through the unorm format
+    precise double value = clamp((res + 1.0LF) / 2.0LF, 0.0LF, 1.0LF);
+    int byteValue = int(value * 255.0LF);
+    imageStore(uTarget, texel, vec4(float(byteValue) / 255.0));
+}
+
+#else
+
+// 3D improved Perlin noise on a lattice that repeats every `period` cells
+double perlin(double x, double y, double z, int period)
+{
+    double fx = floor(x), fy = floor(y), fz = floor(z);
+    int X0 = wrapCell(int(fx), period) & 255, X1 = wrapCell(int(fx) + 1, period) & 255;
+    int Y0 = wrapCell(int(fy), period) & 255, Y1 = wrapCell(int(fy) + 1, period) & 255;
+    int Z0 = wrapCell(int(fz), period) & 255, Z1 = wrapCell(int(fz) + 1, period) & 255;
+    precise double xr = x - fx;
+    precise double yr = y - fy;
+    precise double zr = z - fz;
+    double u = fade(xr), v = fade(yr), w = fade(zr);
+    int A0 = perm(perm(X0) + Y0), A1 = perm(perm(X0) + Y1);
+    int B0 = perm(perm(X1) + Y0), B1 = perm(perm(X1) + Y1);
+    precise double res = lerpD(w,
+        lerpD(v, lerpD(u, grad(perm(A0 + Z0), xr, yr, zr), grad(perm(B0 + Z0), xr - 1.0LF, yr, zr)),
+                 lerpD(u, grad(perm(A1 + Z0), xr, yr - 1.0LF, zr), grad(perm(B1 + Z0), xr - 1.0LF, yr - 1.0LF, zr))),
+        lerpD(v, lerpD(u, grad(perm(A0 + Z1), xr, yr, zr - 1.0LF), grad(perm(B0 + Z1), xr - 1.0LF, yr, zr - 1.0LF)),
+                 lerpD(u, grad(perm(A1 + Z1), xr, yr - 1.0LF, zr - 1.0LF),
+                          grad(perm(B1 + Z1), xr - 1.0LF, yr - 1.0LF, zr - 1.0LF))));
+    return res;
+}
+
+// Integer lattice hash used to place Worley feature points
+uint hashCell(int x, int y, int z, uint seed)
+{
+    uint h = seed ^ (uint(x) * 0x8da6b343u) ^ (uint(y) * 0xd8163841u) ^ (uint(z) * 0xcb1ab31fu);
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Tileable Worley noise: one feature point per cell, returns 1 - F1 in [0, 1]
+double worley(double x, double y, double z, int period, uint seed)
+{
+    int cx = int(floor(x)), cy = int(floor(y)), cz = int(floor(z));
+    double best = 1e9LF;
+    for (int dz = -1; dz <= 1; dz++)
+    for (int dy = -1; dy <= 1; dy++)
+    for (int dx = -1; dx <= 1; dx++)
+    {
+        int ix = cx + dx, iy = cy + dy, iz = cz + dz;
+        uint h = hashCell(wrapCell(ix, period), wrapCell(iy, period), wrapCell(iz, period), seed);
+        precise double fx = double(ix) + double(h & 1023u) / 1024.0LF;
+        precise double fy = double(iy) + double((h >> 10) & 1023u) / 1024.0LF;
+        precise double fz = double(iz) + double((h >> 20) & 1023u) / 1024.0LF;
+        precise double d = (x - fx) * (x - fx) + (y - fy) * (y - fy) + (z - fz) * (z - fz);
+        best = min(best, d);
+    }
+    precise double r = max(0.0LF, 1.0LF - sqrt(best));
+    return r;
+}
+
+// Tileable fBm of Perlin noise mapped to [0, 1]
+double perlinFbm(double x, double y, double z, int frequency)
+{
+    precise double sum = 0.0LF, amplitude = 1.0LF, norm = 0.0LF;
+    for (int o = 0; o < uOctaves; o++)
+    {
+        int f = frequency << o;
+        sum += amplitude * perlin(x * double(f), y * double(f), z * double(f), f);
+        norm += amplitude;
+        amplitude *= double(uGain);
+    }
+    precise double r = clamp((sum / norm + 1.0LF) * 0.5LF, 0.0LF, 1.0LF);
+    return r;
+}
+
+// Tileable fBm of Worley noise in [0, 1]
+double worleyFbm(double x, double y, double z, int frequency, uint seed)
+{
+    precise double sum = 0.0LF, amplitude = 1.0LF, norm = 0.0LF;
+    for (int o = 0; o < uOctaves; o++)
+    {
+        int f = frequency << o;
+        sum += amplitude * worley(x * double(f), y * double(f), z * double(f), f, seed + uint(o));
+        norm += amplitude;
+        amplitude *= double(uGain);
+    }
+    precise double r = sum / norm;
+    return r;
+}
+
+// Rescales v from [lo0, hi0] to [lo1, hi1]
+double remap(double v, double lo0, double hi0, double lo1, double hi1)
+{
+    precise double r = lo1 + (v - lo0) / (hi0 - lo0) * (hi1 - lo1);
+    return r;
+}
+
+// Same rounding as the quantize lambda in Noise.cpp
+float quantize(double v)
+{
+    precise double scaled = clamp(v, 0.0LF, 1.0LF) * 255.0LF + 0.5LF;
+    return float(int(scaled)) / 255.0;
+}
+
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID);
+    if (texel.x >= uWidth || texel.y >= uHeight || texel.z >= uDepth)
+    return;
+
+    // Texel centers in [0, 1)
+    precise double x = (double(texel.x) + 0.5LF) / double(uWidth);
+    precise double y = (double(texel.y) + 0.5LF) / double(uHeight);
+    precise double z = (double(texel.z) + 0.5LF) / double(uDepth);
+    uint seed = uint(uWorleySeed);
+
+    // Perlin-Worley: Perlin fBm eroded by inverted Worley fBm at the same frequency
+    double pf = perlinFbm(x, y, z, uBaseFrequency);
+    double wf = worleyFbm(x, y, z, uBaseFrequency, seed);
+    double perlinWorley = remap(pf, wf - 1.0LF, 1.0LF, 0.0LF, 1.0LF);
+
+    imageStore(uTarget, texel, vec4(quantize(perlinWorley),
+                                    quantize(worleyFbm(x, y, z, uBaseFrequency * 2, seed + 101u)),
+                                    quantize(worleyFbm(x, y, z, uBaseFrequency * 4, seed + 202u)),
+                                    quantize(worleyFbm(x, y, z, uBaseFrequency * 8, seed + 303u))));
+}
+
+#endif
@@ -0,0 +1,24 @@
+#version 330 core
+
+// Temporal resolve (FramePipeline): writes the pixels marched this frame into the new
+// history, blended with what was there, and carries every other pixel over unchanged
+out vec4 FragColor;
+
+uniform sampler2D uMarched;      // Cloud pass at 1/uTemporalCell of the resolution
+uniform sampler2D uHistory;      // Previous frame's result at full resolution
+uniform int uTemporalCell;
+uniform int uTemporalPhase;      // Position within the block marched this frame (x + y * cell)
+uniform float uHistoryWeight;    // Share of the history kept for marched pixels
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 history = texelFetch(uHistory, pixel, 0);
+    ivec2 inCell = pixel % uTemporalCell;
+    if (inCell.x + inCell.y * uTemporalCell != uTemporalPhase) {
+        FragColor = history;
+        return;
+    }
+    vec4 marched = texelFetch(uMarched, pixel / uTemporalCell, 0);
+    FragColor = mix(marched, history, uHistoryWeight);
+}
@@ -0,0 +1,36 @@
+#version 330 core
+
+// Depth-aware upsample (FramePipeline): fills the framebuffer from the cloud rendered at
+// 1/uScale of its size. Each pixel blends the four nearest low-resolution texels with
+// bilinear weights, scaled down where a texel's depth differs from the texel the pixel
+// lies in, so the cloud silhouette stays sharp instead of bleeding into the background.
+out vec4 FragColor;
+
+uniform sampler2D uLowRes;       // rgb = color, a = normalized depth of the first dense sample
+uniform int uScale;
+
+// How quickly a depth difference removes a texel from the blend
+const float kDepthSharpness = 40.0;
+
+void main()
+{
+    ivec2 size = textureSize(uLowRes, 0);
+    vec2 coord = gl_FragCoord.xy / float(uScale) - 0.5;
+    ivec2 base = ivec2(floor(coord));
+    vec2 f = coord - vec2(base);
+    // The texel covering this pixel guides the blend; there is no full-resolution depth
+    float guide = texelFetch(uLowRes, ivec2(gl_FragCoord.xy) / uScale, 0).a;
+
+    vec3 color = vec3(0.0);
+    float weightSum = 0.0;
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            vec4 texel = texelFetch(uLowRes, clamp(base + ivec2(x, y), ivec2(0), size - 1), 0);
+            vec2 bilinear = mix(1.0 - f, f, vec2(x, y));
+            float weight = bilinear.x * bilinear.y * exp(-abs(texel.a - guide) * kDepthSharpness) + 1e-4;
+            color += texel.rgb * weight;
+            weightSum += weight;
+        }
+    }
+    FragColor = vec4(color / weightSum, 1.0);
+}
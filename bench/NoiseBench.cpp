@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "src/MipChain.h"
+#include "src/Noise.h"
+
+// Noise texture throughput in texels/s for each Noise::Mode: the scalar reference, the
+// threaded deterministic path and the threaded SIMD path; then the R16 and packed-octave
+// formats and the CPU mip chain builder. Arguments are the edge length.
+namespace {
+    void reportTexels(benchmark::State& state, double texels)
+    {
+        state.counters["texels/s"] = benchmark::Counter(texels, benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    // Into a reused buffer, so the numbers measure the generator and not the allocator
+    void perlinTexture(benchmark::State& state, Noise::Mode mode)
+    {
+        int size = (int)state.range(0);
+        PerlinNoise perlin(1);
+        std::vector<unsigned char> texels((size_t)size * size);
+        for (auto _ : state) {
+            Noise::generatePerlinNoiseTexture(perlin, size, size, Span<unsigned char>(texels), mode);
+            benchmark::DoNotOptimize(texels.data());
+            benchmark::ClobberMemory();
+        }
+        reportTexels(state, (double)size * size);
+    }
+
+    // The wider formats, on the thread pool
+    void perlinTextureFormat(benchmark::State& state, Noise::Format format)
+    {
+        int size = (int)state.range(0);
+        PerlinNoise perlin(1);
+        std::vector<unsigned char> texels((size_t)size * size * Noise::bytesPerTexel(format));
+        for (auto _ : state) {
+            Noise::generatePerlinNoiseTexture(perlin, size, size, format, Span<unsigned char>(texels));
+            benchmark::DoNotOptimize(texels.data());
+            benchmark::ClobberMemory();
+        }
+        reportTexels(state, (double)size * size);
+    }
+
+    // Levels 1 and up of an R8 texture; the rate counts the level 0 texels filtered
+    void mipChain(benchmark::State& state, MipFilter filter)
+    {
+        int size = (int)state.range(0);
+        std::vector<unsigned char> level0 = Noise::generatePerlinNoiseTexture(size, size, 1);
+        MipChain chain;
+        for (auto _ : state) {
+            chain.build(level0.data(), size, size, 1, 1, 1, filter);
+            benchmark::DoNotOptimize(chain.data(1));
+        }
+        reportTexels(state, (double)size * size);
+    }
+
+    void perlinWorleyVolume(benchmark::State& state)
+    {
+        int size = (int)state.range(0);
+        std::vector<unsigned char> texels((size_t)size * size * size * 4);
+        for (auto _ : state) {
+            Noise::generatePerlinWorleyVolume(size, 1, NoiseVolumeParams(), Span<unsigned char>(texels));
+            benchmark::DoNotOptimize(texels.data());
+            benchmark::ClobberMemory();
+        }
+        reportTexels(state, (double)size * size * size);
+    }
+}
+
+BENCHMARK_CAPTURE(perlinTexture, scalar, Noise::Mode::Scalar)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(perlinTexture, threaded, Noise::Mode::Deterministic)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(perlinTexture, simd_threaded, Noise::Mode::Fast)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(perlinTextureFormat, r16, Noise::Format::R16)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(perlinTextureFormat, rgba8_octaves, Noise::Format::RGBA8Octaves)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(mipChain, box, MipFilter::Box)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(mipChain, kaiser, MipFilter::Kaiser)
+    ->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(perlinWorleyVolume)->Arg(32)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
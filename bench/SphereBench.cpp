@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "src/Cloud.h"
+#include "src/Random.h"
+#include "src/SphereSet.h"
+
+// Sphere generation and bounding throughput in spheres/s over the sphere count N:
+// the array-of-structs generator per RNG, the structure-of-arrays generator into a reused
+// set, the threaded batch generator, and computeBoundingSphere on both layouts.
+namespace {
+    const float kCloudSize = 10.0f;
+    const std::uint32_t kSeed = 1;
+
+    void reportSpheres(benchmark::State& state, double spheres)
+    {
+        state.counters["spheres/s"] = benchmark::Counter(spheres, benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    // A generator whose draws collapse (e.g. every uniformFloat 0) yields copies of one
+    // sphere; its rate would not be comparable, so the benchmark refuses to report one
+    bool spheresVary(const std::vector<Sphere>& spheres)
+    {
+        for (const Sphere& s : spheres) {
+            if (s.center != spheres.front().center || s.radius != spheres.front().radius) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <class Rng>
+    void generateSpheres(benchmark::State& state)
+    {
+        int count = (int)state.range(0);
+        Rng rng(kSeed);
+        if (!spheresVary(generateCloudSpheres(rng, kCloudSize, count))) {
+            state.SkipWithError("generator returned identical spheres");
+            return;
+        }
+        for (auto _ : state) {
+            std::vector<Sphere> spheres = generateCloudSpheres(rng, kCloudSize, count);
+            benchmark::DoNotOptimize(spheres.data());
+        }
+        reportSpheres(state, count);
+    }
+
+    void generateSphereSet(benchmark::State& state)
+    {
+        int count = (int)state.range(0);
+        SphereSet set;
+        for (auto _ : state) {
+            generateCloudSphereSet(set, kCloudSize, count, kSeed);
+            benchmark::DoNotOptimize(set.x());
+        }
+        reportSpheres(state, count);
+    }
+
+    // 16 clouds of N spheres, spread over ThreadPool::shared()
+    void generateBatch(benchmark::State& state)
+    {
+        const int clouds = 16;
+        int count = (int)state.range(0);
+        for (auto _ : state) {
+            std::vector<std::vector<Sphere>> batch = generateCloudBatch(clouds, kSeed, kCloudSize, count);
+            benchmark::DoNotOptimize(batch.data());
+        }
+        reportSpheres(state, (double)clouds * count);
+    }
+
+    // From std::vector<Sphere>, which includes the conversion to a SphereSet
+    void boundingFromVector(benchmark::State& state, BoundingMethod method)
+    {
+        int count = (int)state.range(0);
+        std::vector<Sphere> spheres = generateCloudSpheres(kCloudSize, count, kSeed);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(computeBoundingSphere(spheres, method));
+        }
+        reportSpheres(state, count);
+    }
+
+    // Straight from the SIMD-friendly layout
+    void boundingFromSet(benchmark::State& state, BoundingMethod method)
+    {
+        int count = (int)state.range(0);
+        SphereSet set = generateCloudSphereSet(kCloudSize, count, kSeed);
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(computeBoundingSphere(set, method));
+        }
+        reportSpheres(state, count);
+    }
+}
+
+BENCHMARK_TEMPLATE(generateSpheres, Pcg32)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK_TEMPLATE(generateSpheres, Xoshiro256)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK_TEMPLATE(generateSpheres, std::mt19937)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(generateSphereSet)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(generateBatch)->RangeMultiplier(10)->Range(100, 10000)->UseRealTime();
+
+BENCHMARK_CAPTURE(boundingFromVector, box, BoundingMethod::Box)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK_CAPTURE(boundingFromVector, ritter, BoundingMethod::Ritter)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK_CAPTURE(boundingFromSet, box, BoundingMethod::Box)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK_CAPTURE(boundingFromSet, ritter, BoundingMethod::Ritter)->RangeMultiplier(10)->Range(100, 100000);
@@ -0,0 +1,135 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    double nowMs()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+Benchmark::Benchmark(const Options& options)
+    : settings(options)
+{
+    for (int spheres : settings.sphereCounts) {
+        for (const glm::ivec2& size : settings.sizes) {
+            for (int steps : settings.marchSteps) {
+                for (int shadowSteps : settings.shadowSteps) {
+                    Config config;
+                    config.width = size.x;
+                    config.height = size.y;
+                    config.spheres = spheres;
+                    config.marchSteps = steps;
+                    config.shadowSteps = shadowSteps;
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+    settings.measuredFrames = std::max(settings.measuredFrames, 1);
+    settings.warmupFrames = std::max(settings.warmupFrames, 0);
+}
+
+Benchmark::~Benchmark()
+{
+    glDeleteFramebuffers(1, &target);
+    glDeleteRenderbuffers(1, &color);
+}
+
+void Benchmark::resize(int width, int height)
+{
+    if (width == targetWidth && height == targetHeight) {
+        return;
+    }
+    glDeleteFramebuffers(1, &target);
+    glDeleteRenderbuffers(1, &color);
+    targetWidth = width;
+    targetHeight = height;
+
+    // The same format as a typical default framebuffer, so the final pass costs the same
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &target);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error::Benchmark::Framebuffer incomplete (" << width << "x" << height << ")" << std::endl;
+    }
+}
+
+void Benchmark::beginFrame()
+{
+    const Config& c = config();
+    resize(c.width, c.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glFinish();
+    frameStart = nowMs();
+}
+
+void Benchmark::endFrame()
+{
+    glFinish();
+    double elapsed = nowMs() - frameStart;
+    if (frame >= settings.warmupFrames) {
+        frameMs.push_back(elapsed);
+    }
+    frame++;
+    if (frame == settings.warmupFrames + settings.measuredFrames) {
+        finishConfig();
+    }
+}
+
+void Benchmark::finishConfig()
+{
+    std::vector<double> sorted(frameMs);
+    std::sort(sorted.begin(), sorted.end());
+    Result r;
+    r.config = config();
+    r.meanMs = 0.0;
+    for (double ms : sorted) {
+        r.meanMs += ms;
+    }
+    r.meanMs /= (double)sorted.size();
+    r.p50Ms = sorted[std::min(sorted.size() - 1, sorted.size() / 2)];
+    r.p95Ms = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+    r.minMs = sorted.front();
+    r.maxMs = sorted.back();
+    results.push_back(r);
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "[bench %zu/%zu] %dx%d spheres=%d steps=%d shadow=%d: mean %.3f ms, p95 %.3f ms",
+                  current + 1, configs.size(), r.config.width, r.config.height, r.config.spheres,
+                  r.config.marchSteps, r.config.shadowSteps, r.meanMs, r.p95Ms);
+    std::cout << line << std::endl;
+
+    frameMs.clear();
+    frame = 0;
+    current++;
+}
+
+bool Benchmark::writeCsv() const
+{
+    std::ofstream file(settings.csvPath, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error::Benchmark::Could not write " << settings.csvPath << std::endl;
+        return false;
+    }
+    file << "width,height,spheres,march_steps,shadow_steps,march,pass,temporal,scale,seed,"
+            "frames,mean_ms,p50_ms,p95_ms,min_ms,max_ms\n";
+    char line[256];
+    for (const Result& r : results) {
+        std::snprintf(line, sizeof(line), "%d,%d,%d,%d,%d,%s,%s,%d,%d,%u,%d,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                      r.config.width, r.config.height, r.config.spheres, r.config.marchSteps, r.config.shadowSteps,
+                      settings.mode.march.c_str(), settings.mode.pass.c_str(), settings.mode.temporal,
+                      settings.mode.scale, (unsigned)settings.seed, settings.measuredFrames,
+                      r.meanMs, r.p50Ms, r.p95Ms, r.minMs, r.maxMs);
+        file << line;
+    }
+    return (bool)file;
+}
@@ -0,0 +1,97 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Offline benchmark (--bench): renders a sweep of configurations into an offscreen
+// framebuffer, with warm-up frames followed by measured frames for each one. Every
+// measured frame is bounded by glFinish on both ends, so it times the GPU work as well.
+// One CSV row per configuration is written at the end, in a stable order, so files from
+// two builds can be diffed.
+class Benchmark
+{
+public:
+    // One point of the sweep
+    struct Config {
+        int width = 0;
+        int height = 0;
+        int spheres = 0;
+        int marchSteps = 0;
+        int shadowSteps = 0;
+    };
+
+    // Render settings that stay fixed for the whole run; written as CSV columns
+    struct Mode {
+        std::string march = "fixed";
+        std::string pass = "fragment";
+        int temporal = 1;
+        int scale = 1;
+    };
+
+    struct Options {
+        std::vector<glm::ivec2> sizes = { {640, 360}, {1280, 720}, {1920, 1080} };
+        std::vector<int> sphereCounts = { 20, 100, 300 };
+        std::vector<int> marchSteps = { 32, 64, 128 };
+        std::vector<int> shadowSteps = { 8, 16 };
+        int warmupFrames = 10;
+        int measuredFrames = 50;
+        std::uint32_t seed = 1;         // generateCloudSpheres seed, the same for every run
+        std::string csvPath = "bench.csv";
+        Mode mode;
+    };
+
+    // Expands the sweep: sphere count outermost (it rebuilds the scene), then the
+    // size and the step counts
+    explicit Benchmark(const Options& options);
+    ~Benchmark();
+    Benchmark(const Benchmark&) = delete;
+    Benchmark& operator=(const Benchmark&) = delete;
+
+    bool done() const { return current >= configs.size(); }
+    const Config& config() const { return configs[current]; }
+    // True on the first frame of a configuration, when the caller applies it
+    bool configStarting() const { return frame == 0; }
+    const Options& options() const { return settings; }
+
+    // Sizes and binds the offscreen target for the current configuration, then waits
+    // for the GPU so the frame starts idle
+    void beginFrame();
+    // Waits for the GPU and records the frame; moves on after the measured frames
+    void endFrame();
+    GLuint framebuffer() const { return target; }
+
+    // Writes the header and one row per finished configuration
+    bool writeCsv() const;
+
+private:
+    struct Result {
+        Config config;
+        double meanMs;
+        double p50Ms;
+        double p95Ms;
+        double minMs;
+        double maxMs;
+    };
+
+    void resize(int width, int height);
+    void finishConfig();
+
+    Options settings;
+    std::vector<Config> configs;
+    std::vector<Result> results;
+    std::vector<double> frameMs;        // Measured frames of the current configuration
+    size_t current = 0;
+    int frame = 0;
+
+    GLuint target = 0;
+    GLuint color = 0;
+    int targetWidth = 0;
+    int targetHeight = 0;
+    double frameStart = 0.0;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,14 @@
+#ifndef CACHEPATHS_H
+#define CACHEPATHS_H
+
+#include <cstdlib>
+#include <string>
+
+// Root directory for on-disk caches (noise textures, program binaries):
+// $CLOUD_CACHE_DIR when set, otherwise ./cache
+inline std::string cacheDirectory() {
+    const char* env = std::getenv("CLOUD_CACHE_DIR");
+    return env && *env ? env : "cache";
+}
+
+#endif // CACHEPATHS_H
@@ -0,0 +1,41 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glm/glm.hpp>
+#include "SphereSet.h"
+
+// Pinhole camera of the cloud passes, written into FrameBlock every frame. A pixel at
+// uv in [-1, 1]^2 looks along forward + uv.x * tanHalfFov.x * right + uv.y * tanHalfFov.y * up.
+struct Camera {
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 forward = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 right = glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec2 tanHalfFov = glm::vec2(0.5f);
+    float depthRange = 1.0f;        // Distance written as depth 1 to the cloud pass alpha
+
+    // The original fixed view: from +z at twice the sphere's radius off its center, with
+    // the far side of the sphere at depth 1
+    static Camera framing(const Sphere& bounds)
+    {
+        Camera camera;
+        camera.position = bounds.center + glm::vec3(0.0f, 0.0f, bounds.radius * 2.0f);
+        camera.depthRange = bounds.radius * 3.0f;
+        return camera;
+    }
+
+    // Moves along the view axes; the orientation stays
+    void translate(float alongForward, float alongRight)
+    {
+        position += forward * alongForward + right * alongRight;
+    }
+
+    bool operator==(const Camera& other) const
+    {
+        return position == other.position && forward == other.forward && right == other.right &&
+               up == other.up && tanHalfFov == other.tanHalfFov && depthRange == other.depthRange;
+    }
+    bool operator!=(const Camera& other) const { return !(*this == other); }
+};
+
+#endif // CAMERA_H
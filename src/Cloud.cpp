@@ -0,0 +1,211 @@
+#include "Cloud.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    // Pair of standard normal variates (Box-Muller); one call per sphere position
+    template <class Rng>
+    glm::vec2 gaussianPair(Rng& rng)
+    {
+        float u1 = 1.0f - uniformFloat(rng);    // (0, 1], so the log is finite
+        float u2 = uniformFloat(rng);
+        float r = std::sqrt(-2.0f * std::log(u1));
+        float angle = 6.28318531f * u2;
+        return glm::vec2(r * std::cos(angle), r * std::sin(angle));
+    }
+
+    // Beta(alpha, beta) sampler, set up once per cloud. For integer shapes (the default 2, 5)
+    // a Beta variate is the alpha-th smallest of alpha + beta - 1 uniforms, which needs no
+    // logarithms at all. Other shapes use the gamma ratio with distributions built once.
+    class BetaSampler
+    {
+    public:
+        static const int kMaxOrderSamples = 16;
+
+        BetaSampler(float alpha, float beta)
+            : gammaA(alpha, 1.0f), gammaB(beta, 1.0f)
+        {
+            int a = (int)alpha;
+            int b = (int)beta;
+            if ((float)a == alpha && (float)b == beta && a >= 1 && b >= 1 && a + b - 1 <= kMaxOrderSamples) {
+                rank = a;
+                samples = a + b - 1;
+            }
+        }
+
+        template <class Rng>
+        float operator()(Rng& rng)
+        {
+            if (rank == 0) {
+                float x = gammaA(rng);
+                float y = gammaB(rng);
+                return x / (x + y);
+            }
+            // Keep the `rank` smallest draws sorted; the largest of them is the answer
+            float smallest[kMaxOrderSamples];
+            int kept = 0;
+            for (int i = 0; i < samples; i++) {
+                float u = uniformFloat(rng);
+                if (kept == rank && u >= smallest[kept - 1]) {
+                    continue;
+                }
+                int j = kept < rank ? kept++ : kept - 1;
+                while (j > 0 && smallest[j - 1] > u) {
+                    smallest[j] = smallest[j - 1];
+                    j--;
+                }
+                smallest[j] = u;
+            }
+            return smallest[rank - 1];
+        }
+
+    private:
+        int rank = 0;                   // 0 = gamma fallback
+        int samples = 0;
+        std::gamma_distribution<float> gammaA;
+        std::gamma_distribution<float> gammaB;
+    };
+}
+
+// Function to generate a collection of spheres that form a cloud-like shape. Replaces the
+// contents of `spheres`, whose storage is reused once it has held N spheres.
+template <class Rng>
+static void fillCloudSphereSet(
+    Rng& rng, SphereSet& spheres, float L, int N, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    spheres.clear();
+    spheres.reserve(N);
+
+    auto randf = [&]() { return uniformFloat(rng); };
+
+    // Gaussian distribution for random positioning
+    float sigma = L * sigma_ratio;
+
+    float delta = L * delta_ratio;
+    glm::vec2 center2D(L/2, L/2);
+
+    // Generate a base sphere that serves as the foundation
+    float base_y = randf() * (delta / 2.0f);
+    float dx = L/2.0f;
+    float dz = L/2.0f;
+    float max_base_radius = std::min(std::min(dx, dz), (L - base_y)*0.5f);
+    float base_radius = std::min(L * base_radius_ratio, max_base_radius);
+
+    {
+        Sphere s;
+        s.center = glm::vec3(center2D.x, base_y + base_radius, center2D.y);
+        s.radius = base_radius;
+        spheres.push_back(s);
+    }
+
+    BetaSampler betaRand(alpha, beta);
+
+    // Generate additional spheres
+    for(int i=0; i<N-1; i++)
+    {
+        glm::vec2 g = center2D + sigma * gaussianPair(rng);
+        float x = std::max(0.0f, std::min(L, g.x));
+        float z = std::max(0.0f, std::min(L, g.y));
+        float dx_ = std::min(x, L - x);
+        float dz_ = std::min(z, L - z);
+        float y_base = randf() * delta;
+
+        float max_radius_y = (L - y_base)*0.5f;
+        float d_max = std::min(std::min(dx_, dz_), max_radius_y);
+
+        float min_radius = std::max(0.05f*L, base_radius*0.2f);
+        float max_radius = std::min(d_max, 0.5f*L);
+
+        float br = betaRand(rng);
+        float radius = min_radius + br*(max_radius - min_radius);
+
+        Sphere s;
+        s.center = glm::vec3(x, y_base + radius, z);
+        s.radius = radius;
+        spheres.push_back(s);
+    }
+}
+
+template <class Rng>
+SphereSet generateCloudSphereSet(
+    Rng& rng, float L, int N, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    SphereSet spheres;
+    fillCloudSphereSet(rng, spheres, L, N, delta_ratio, sigma_ratio, alpha, beta, base_radius_ratio);
+    return spheres;
+}
+
+template <class Rng>
+std::vector<Sphere> generateCloudSpheres(
+    Rng& rng, float L, int N, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    return generateCloudSphereSet(rng, L, N, delta_ratio, sigma_ratio, alpha, beta, base_radius_ratio).toSpheres();
+}
+
+// uniformFloat takes its top 24 bits from each generator's range, not from result_type
+static_assert(randomBits<Pcg32>() == 32, "Pcg32 draws 32 bits");
+static_assert(randomBits<Xoshiro256>() == 64, "Xoshiro256 draws 64 bits");
+static_assert(randomBits<std::mt19937>() == 32, "std::mt19937 draws 32 bits, whatever the width of uint_fast32_t");
+
+template SphereSet generateCloudSphereSet<Pcg32>(
+    Pcg32&, float, int, float, float, float, float, float);
+template SphereSet generateCloudSphereSet<Xoshiro256>(
+    Xoshiro256&, float, int, float, float, float, float, float);
+template SphereSet generateCloudSphereSet<std::mt19937>(
+    std::mt19937&, float, int, float, float, float, float, float);
+template std::vector<Sphere> generateCloudSpheres<Pcg32>(
+    Pcg32&, float, int, float, float, float, float, float);
+template std::vector<Sphere> generateCloudSpheres<Xoshiro256>(
+    Xoshiro256&, float, int, float, float, float, float, float);
+template std::vector<Sphere> generateCloudSpheres<std::mt19937>(
+    std::mt19937&, float, int, float, float, float, float, float);
+
+std::vector<Sphere> generateCloudSpheres(
+    float L, int N, std::uint32_t seed, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    Pcg32 rng(seed, 0);
+    return generateCloudSpheres(rng, L, N, delta_ratio, sigma_ratio, alpha, beta, base_radius_ratio);
+}
+
+SphereSet generateCloudSphereSet(
+    float L, int N, std::uint32_t seed, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    Pcg32 rng(seed, 0);
+    return generateCloudSphereSet(rng, L, N, delta_ratio, sigma_ratio, alpha, beta, base_radius_ratio);
+}
+
+void generateCloudSphereSet(
+    SphereSet& out, float L, int N, std::uint32_t seed, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    Pcg32 rng(seed, 0);
+    fillCloudSphereSet(rng, out, L, N, delta_ratio, sigma_ratio, alpha, beta, base_radius_ratio);
+}
+
+std::vector<std::vector<Sphere>> generateCloudBatch(
+    int count, std::uint32_t seed, float L, int N, float delta_ratio, float sigma_ratio,
+    float alpha, float beta, float base_radius_ratio)
+{
+    std::vector<std::vector<Sphere>> clouds(std::max(count, 0));
+    // A few clouds per chunk amortizes the scheduling; each writes only its own slot
+    ThreadPool::shared().parallelFor(count, 4, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            Pcg32 rng(seed, (std::uint64_t)i);
+            clouds[i] = generateCloudSpheres(rng, L, N, delta_ratio, sigma_ratio, alpha, beta, base_radius_ratio);
+        }
+    });
+    return clouds;
+}
+
+// Compute a bounding sphere that encompasses all generated spheres
+Sphere computeBoundingSphere(const std::vector<Sphere>& spheres, BoundingMethod method)
+{
+    return computeBoundingSphere(SphereSet(spheres), method);
+}
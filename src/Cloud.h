@@ -0,0 +1,61 @@
+#ifndef CLOUD_H
+#define CLOUD_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Random.h"
+#include "SphereSet.h"
+
+// Function to generate a collection of spheres that form a cloud-like shape, drawing from
+// any UniformRandomBitGenerator. Instantiated for Pcg32, Xoshiro256 and std::mt19937.
+template <class Rng>
+std::vector<Sphere> generateCloudSpheres(
+    Rng& rng, float L, int N, float delta_ratio=0.1f, float sigma_ratio=0.2f,
+    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f);
+
+// Same, written straight into structure-of-arrays storage (the vector overloads convert this)
+template <class Rng>
+SphereSet generateCloudSphereSet(
+    Rng& rng, float L, int N, float delta_ratio=0.1f, float sigma_ratio=0.2f,
+    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f);
+
+// Same with a Pcg32 seeded from `seed`; the same seed always produces the same spheres
+std::vector<Sphere> generateCloudSpheres(
+    float L, int N, std::uint32_t seed, float delta_ratio=0.1f, float sigma_ratio=0.2f,
+    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f);
+
+SphereSet generateCloudSphereSet(
+    float L, int N, std::uint32_t seed, float delta_ratio=0.1f, float sigma_ratio=0.2f,
+    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f);
+
+// Same into an existing set, reusing its storage: regenerating N spheres no longer allocates
+void generateCloudSphereSet(
+    SphereSet& out, float L, int N, std::uint32_t seed, float delta_ratio=0.1f, float sigma_ratio=0.2f,
+    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f);
+
+// Generates `count` clouds in parallel on ThreadPool::shared(). Cloud i draws from PCG
+// stream i of `seed` (cloud 0 matches the single-cloud overload), so the result does not
+// depend on the number of threads.
+std::vector<std::vector<Sphere>> generateCloudBatch(
+    int count, std::uint32_t seed, float L, int N, float delta_ratio=0.1f, float sigma_ratio=0.2f,
+    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f);
+
+extern template std::vector<Sphere> generateCloudSpheres<Pcg32>(
+    Pcg32&, float, int, float, float, float, float, float);
+extern template std::vector<Sphere> generateCloudSpheres<Xoshiro256>(
+    Xoshiro256&, float, int, float, float, float, float, float);
+extern template std::vector<Sphere> generateCloudSpheres<std::mt19937>(
+    std::mt19937&, float, int, float, float, float, float, float);
+extern template SphereSet generateCloudSphereSet<Pcg32>(
+    Pcg32&, float, int, float, float, float, float, float);
+extern template SphereSet generateCloudSphereSet<Xoshiro256>(
+    Xoshiro256&, float, int, float, float, float, float, float);
+extern template SphereSet generateCloudSphereSet<std::mt19937>(
+    std::mt19937&, float, int, float, float, float, float, float);
+
+// Compute a bounding sphere that encompasses all generated spheres
+Sphere computeBoundingSphere(const std::vector<Sphere>& spheres, BoundingMethod method = BoundingMethod::Box);
+
+#endif // CLOUD_H
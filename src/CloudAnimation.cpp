@@ -0,0 +1,77 @@
+#include "CloudAnimation.h"
+#include <algorithm>
+#include <cmath>
+#include "Random.h"
+#include "ThreadPool.h"
+
+namespace {
+    // Spheres condense over the first 30% of a cycle and dissipate over the last 40%
+    const float kGrowEnd = 0.3f;
+    const float kFadeStart = 0.6f;
+
+    float smoothstep(float edge0, float edge1, float x)
+    {
+        float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    // Radius fraction over one cycle, zero at both ends
+    float envelope(float age)
+    {
+        return smoothstep(0.0f, kGrowEnd, age) * (1.0f - smoothstep(kFadeStart, 1.0f, age));
+    }
+}
+
+CloudAnimation::CloudAnimation(const std::vector<Sphere>& rest, std::uint32_t seed, const CloudAnimationParams& params)
+    : base(rest), config(params), seed(seed)
+{
+    config.maxLifetime = std::max(config.maxLifetime, config.minLifetime);
+    tracks.resize(base.size());
+    for (size_t i = 0; i < base.size(); i++)
+    {
+        Pcg32 rng(seed, i);
+        tracks[i].lifetime = config.minLifetime + (config.maxLifetime - config.minLifetime) * uniformFloat(rng);
+        tracks[i].phase = uniformFloat(rng);
+    }
+}
+
+// Sphere i during cycle k = floor(time / lifetime + phase). Each cycle draws its spawn
+// offset and peak radius from PCG stream i, seeded with the cycle number.
+Sphere CloudAnimation::sphereAt(int i, double time) const
+{
+    const Track& track = tracks[i];
+    double cycles = time / track.lifetime + track.phase;
+    double cycle = std::floor(cycles);
+    float age = (float)(cycles - cycle);
+
+    Pcg32 rng((std::uint64_t)seed ^ ((std::uint64_t)(std::int64_t)cycle * 0x9e3779b97f4a7c15ull), (std::uint64_t)i);
+    glm::vec3 offset(uniformFloat(rng), uniformFloat(rng), uniformFloat(rng));
+    float size = 1.0f + config.sizeVariation * (2.0f * uniformFloat(rng) - 1.0f);
+
+    // The drift is centered on the cycle, so the spheres stay near their rest positions
+    const Sphere& rest = base[i];
+    Sphere s;
+    s.center = rest.center + (offset * 2.0f - 1.0f) * (config.jitter * rest.radius)
+             + config.wind * ((age - 0.5f) * track.lifetime);
+    s.radius = rest.radius * size * envelope(age);
+    return s;
+}
+
+void CloudAnimation::evaluate(double time, std::vector<Sphere>& out) const
+{
+    out.resize(base.size());
+    ThreadPool::shared().parallelFor((int)base.size(), 256, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            out[i] = sphereAt(i, time);
+    });
+}
+
+float CloudAnimation::maxSurfaceSpeed() const
+{
+    float largest = 0.0f;
+    for (const Sphere& s : base)
+        largest = std::max(largest, s.radius);
+    // The steepest part of the envelope is the middle of the growth phase, 1.5 / kGrowEnd per cycle
+    float growth = largest * (1.0f + config.sizeVariation) * 1.5f / kGrowEnd / config.minLifetime;
+    return glm::length(config.wind) + growth;
+}
@@ -0,0 +1,55 @@
+#ifndef CLOUDANIMATION_H
+#define CLOUDANIMATION_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "SphereSet.h"
+
+// Shape of the wind evolution; the defaults suit the default cloud size (L = 10)
+struct CloudAnimationParams {
+    glm::vec3 wind = glm::vec3(0.12f, 0.0f, 0.05f);    // Drift in cloud units per second
+    float minLifetime = 8.0f;                           // Seconds per cycle, drawn per sphere
+    float maxLifetime = 16.0f;
+    float jitter = 0.5f;                                // Respawn offset, in rest radii
+    float sizeVariation = 0.2f;                         // Peak radius range around the rest radius
+};
+
+// Wind-driven evolution of a generated cloud (--animate). Every sphere lives through
+// repeated cycles of its own length: it condenses near its rest position, grows, drifts
+// with the wind and dissipates, then reappears at a new jittered spot. The state is a
+// pure function of time, so any frame can be evaluated on its own and a recording is
+// reproducible. Radii reach zero at the end of a cycle, so the respawn never pops.
+class CloudAnimation
+{
+public:
+    CloudAnimation() = default;
+    CloudAnimation(const std::vector<Sphere>& rest, std::uint32_t seed,
+                   const CloudAnimationParams& params = CloudAnimationParams());
+
+    bool empty() const { return base.empty(); }
+    int size() const { return (int)base.size(); }
+
+    // The spheres at `time`, in the order of the rest spheres, evaluated in parallel
+    // on ThreadPool::shared()
+    void evaluate(double time, std::vector<Sphere>& out) const;
+
+    // Upper bound on how fast any sphere surface moves, in cloud units per second; a
+    // distance field baked t seconds ago is off by at most t times this
+    float maxSurfaceSpeed() const;
+
+private:
+    struct Track {
+        float lifetime;
+        float phase;        // Offset into the first cycle, in [0, 1)
+    };
+
+    Sphere sphereAt(int i, double time) const;
+
+    std::vector<Sphere> base;
+    std::vector<Track> tracks;
+    CloudAnimationParams config;
+    std::uint32_t seed = 0;
+};
+
+#endif // CLOUDANIMATION_H
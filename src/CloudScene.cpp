@@ -0,0 +1,219 @@
+#include "CloudScene.h"
+#include "Random.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+namespace {
+    // std140 mirror of `uniform InstanceBlock` in cloud_instances.glsl
+    struct InstanceBlockData {
+        int count;
+        int pad[3];
+        float instances[CloudScene::kMaxVisible][4];
+    };
+    static_assert(offsetof(InstanceBlockData, instances) == 16, "std140 offset of uInstances");
+
+    // Distance from the camera's near plane, as a fraction of its depth range, that the
+    // proxy projection in cloud_vertex_shader.glsl clips at
+    const float kNearPlane = 0.001f;
+
+    // True if the sphere reaches into the frustum: in front of the camera and inside all
+    // four side planes (each plane through the camera, padded by the radius)
+    bool inFrustum(const Camera& camera, const Sphere& s)
+    {
+        glm::vec3 v = s.center - camera.position;
+        float z = glm::dot(v, camera.forward);
+        if (z < -s.radius) {
+            return false;
+        }
+        float x = std::fabs(glm::dot(v, camera.right));
+        float y = std::fabs(glm::dot(v, camera.up));
+        float tx = camera.tanHalfFov.x;
+        float ty = camera.tanHalfFov.y;
+        return x - tx * z <= s.radius * std::sqrt(1.0f + tx * tx) &&
+               y - ty * z <= s.radius * std::sqrt(1.0f + ty * ty);
+    }
+
+    bool sameInstance(const CloudInstance& a, const CloudInstance& b)
+    {
+        return a.offset == b.offset && a.scale == b.scale;
+    }
+}
+
+CloudScene::CloudScene(GLuint fullscreenTriangle)
+    : triangle(fullscreenTriangle)
+{
+    glGenBuffers(1, &instanceUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, instanceUbo);
+    InstanceBlockData initial{};
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(InstanceBlockData), &initial, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kInstanceBinding, instanceUbo);
+
+    glGenVertexArrays(1, &proxyVao);
+}
+
+CloudScene::~CloudScene()
+{
+    glDeleteBuffers(1, &instanceUbo);
+    glDeleteVertexArrays(1, &proxyVao);
+}
+
+void CloudScene::setCloudBounds(const Sphere& bounding)
+{
+    cloud = bounding;
+    uploadedOnce = false;
+}
+
+void CloudScene::setInstances(const std::vector<CloudInstance>& placements)
+{
+    all = placements;
+    // update() then fills these without allocating
+    candidates.reserve(all.size());
+    visible.reserve(std::min(all.size(), (size_t)kMaxVisible));
+}
+
+Sphere CloudScene::instanceBounds(const CloudInstance& instance) const
+{
+    return { instance.offset + instance.scale * cloud.center, instance.scale * cloud.radius };
+}
+
+Sphere CloudScene::bounds() const
+{
+    return boundsOf(all, cloud);
+}
+
+Sphere CloudScene::boundsOf(const std::vector<CloudInstance>& placements, const Sphere& cloudBounds)
+{
+    SphereSet set;
+    set.reserve(placements.size());
+    for (const CloudInstance& instance : placements) {
+        set.push_back({ instance.offset + instance.scale * cloudBounds.center, instance.scale * cloudBounds.radius });
+    }
+    return computeBoundingSphere(set, BoundingMethod::Ritter);
+}
+
+std::vector<CloudInstance> CloudScene::scatter(int count, std::uint32_t seed, const Sphere& cloudBounds)
+{
+    std::vector<CloudInstance> placements;
+    if (count <= 1) {
+        placements.resize(std::max(count, 0));
+        return placements;
+    }
+
+    // Stream 0 of the seed generates the spheres; the layout draws from its own stream
+    Pcg32 rng(seed, 1);
+    int side = (int)std::ceil(std::sqrt((float)count));
+    float spacing = 2.5f * cloudBounds.radius;
+    float half = 0.5f * (float)(side - 1);
+    for (int i = 0; i < count; i++) {
+        CloudInstance instance;
+        instance.scale = 0.6f + 0.6f * uniformFloat(rng);
+        glm::vec3 cell((float)(i % side) - half, 0.0f, (float)(i / side) - half);
+        glm::vec3 jitter(uniformFloat(rng) - 0.5f, 0.0f, uniformFloat(rng) - 0.5f);
+        glm::vec3 center = cloudBounds.center + spacing * (cell + 0.5f * jitter);
+        center.y += cloudBounds.radius * 0.5f * uniformFloat(rng);
+        // Place the instance's bounding-sphere center, not its origin, on the grid point
+        instance.offset = center - instance.scale * cloudBounds.center;
+        placements.push_back(instance);
+    }
+    return placements;
+}
+
+void CloudScene::update(const Camera& camera)
+{
+    candidates.clear();
+    for (size_t i = 0; i < all.size(); i++) {
+        Sphere s = instanceBounds(all[i]);
+        if (inFrustum(camera, s)) {
+            candidates.push_back({ glm::length(s.center - camera.position) - s.radius, (int)i });
+        }
+    }
+    // The index breaks ties, so the order does not flicker between equal distances
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.index < b.index;
+    });
+    if (candidates.size() > (size_t)kMaxVisible) {
+        if (!warnedOverflow) {
+            std::cerr << "Error::CloudScene::" << candidates.size() << " visible instances, only the nearest "
+                      << kMaxVisible << " are drawn" << std::endl;
+            warnedOverflow = true;
+        }
+        candidates.resize(kMaxVisible);
+    }
+
+    visible.clear();
+    insideProxy = false;
+    float margin = 2.0f * kNearPlane * camera.depthRange;
+    for (const Candidate& c : candidates) {
+        visible.push_back(all[c.index]);
+        // The proxy's front faces are clipped away once the camera reaches into its box
+        Sphere s = instanceBounds(all[c.index]);
+        glm::vec3 d = glm::abs(camera.position - s.center);
+        if (std::max(std::max(d.x, d.y), d.z) <= s.radius + margin) {
+            insideProxy = true;
+        }
+    }
+
+    bool changed = !uploadedOnce || visible.size() != uploaded.size() ||
+                   !std::equal(visible.begin(), visible.end(), uploaded.begin(), sameInstance);
+    if (!changed) {
+        return;
+    }
+    InstanceBlockData data{};
+    data.count = (int)visible.size();
+    for (size_t i = 0; i < visible.size(); i++) {
+        data.instances[i][0] = visible[i].offset.x;
+        data.instances[i][1] = visible[i].offset.y;
+        data.instances[i][2] = visible[i].offset.z;
+        data.instances[i][3] = visible[i].scale;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, instanceUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, offsetof(InstanceBlockData, instances) + visible.size() * sizeof(data.instances[0]),
+                    &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    uploaded = visible;
+    uploadedOnce = true;
+}
+
+void CloudScene::bindProgram(const Shader& shader) const
+{
+    shader.bindUniformBlock("InstanceBlock", kInstanceBinding);
+}
+
+void CloudScene::draw(const Shader& cloud)
+{
+    if (cloud.ID != programId) {
+        programId = cloud.ID;
+        drawProxiesLoc = cloud.uniform("uDrawProxies");
+        proxyViewportLoc = cloud.uniform("uProxyViewport");
+    }
+    if (insideProxy) {
+        cloud.setBool(drawProxiesLoc, false);
+        glBindVertexArray(triangle);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        return;
+    }
+
+    // Pixels outside every proxy keep what a missed ray returns (kBackground in cloud_march.glsl)
+    GLfloat previous[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, previous);
+    glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(previous[0], previous[1], previous[2], previous[3]);
+    if (visible.empty()) {
+        return;
+    }
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    cloud.setBool(drawProxiesLoc, true);
+    cloud.setVec4(proxyViewportLoc, glm::vec4((float)viewport[0], (float)viewport[1], (float)viewport[2], (float)viewport[3]));
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glBindVertexArray(proxyVao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)visible.size());
+    glBindVertexArray(0);
+    glDisable(GL_CULL_FACE);
+}
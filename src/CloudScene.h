@@ -0,0 +1,89 @@
+#ifndef CLOUDSCENE_H
+#define CLOUDSCENE_H
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Camera.h"
+#include "Shader.h"
+#include "SphereSet.h"
+
+// One placement of the shared cloud: a point p of the cloud's own space lands at offset + scale * p
+struct CloudInstance {
+    glm::vec3 offset = glm::vec3(0.0f);
+    float scale = 1.0f;
+};
+
+// Many instances of one cloud. All of them reference the sphere data, BVH and baked volumes
+// uploaded by SceneUploader. Every frame the instances are culled against the camera
+// frustum and the survivors are sorted front to back into InstanceBlock. The cloud pass
+// draws an instanced box around each survivor's bounding sphere instead of a full-screen
+// triangle. Each covered pixel walks the whole sorted list and stops once it is opaque;
+// where proxies overlap, only the first one in that order shades the pixel.
+class CloudScene
+{
+public:
+    static const int kMaxVisible = 64;          // Must match kMaxInstances in cloud_instances.glsl
+    static const GLuint kInstanceBinding = 2;   // Uniform buffer binding of InstanceBlock
+
+    // fullscreenTriangle is a VAO drawing one triangle that covers the viewport; it is
+    // drawn instead of the proxies while the camera is inside one of them
+    explicit CloudScene(GLuint fullscreenTriangle);
+    ~CloudScene();
+    CloudScene(const CloudScene&) = delete;
+    CloudScene& operator=(const CloudScene&) = delete;
+
+    // Bounding sphere of the shared cloud, in its own space
+    void setCloudBounds(const Sphere& bounding);
+    void setInstances(const std::vector<CloudInstance>& placements);
+    const std::vector<CloudInstance>& instances() const { return all; }
+    // Bounding sphere around every instance's bounding sphere
+    Sphere bounds() const;
+
+    // `count` instances on a jittered grid over the ground plane, drawn from `seed`, with
+    // scales between 0.6 and 1.2. A single instance is the cloud itself, untransformed.
+    static std::vector<CloudInstance> scatter(int count, std::uint32_t seed, const Sphere& cloudBounds);
+    // bounds() of a placement, without a CloudScene (and so without a GL context)
+    static Sphere boundsOf(const std::vector<CloudInstance>& placements, const Sphere& cloudBounds);
+
+    // Culls and sorts the instances for this camera and uploads InstanceBlock if the
+    // visible list changed. Call once per frame before the cloud pass.
+    void update(const Camera& camera);
+    int visibleCount() const { return (int)visible.size(); }
+
+    // Connects a program's InstanceBlock to kInstanceBinding
+    void bindProgram(const Shader& shader) const;
+    // Draws the cloud pass geometry with the bound cloud program (cloud_vertex_shader.glsl):
+    // clears the target to the background and draws the proxies, or the full-screen triangle
+    void draw(const Shader& cloud);
+
+private:
+    struct Candidate {
+        float distance;             // From the camera to the nearest point of the bounding sphere
+        int index;
+    };
+
+    // World-space bounding sphere of an instance
+    Sphere instanceBounds(const CloudInstance& instance) const;
+
+    std::vector<CloudInstance> all;
+    std::vector<Candidate> candidates;      // Instances inside the frustum; reused across frames
+    std::vector<CloudInstance> visible;     // Sorted front to back, at most kMaxVisible
+    std::vector<CloudInstance> uploaded;    // Contents of the InstanceBlock buffer
+    Sphere cloud = { glm::vec3(0.0f), 0.0f };
+    bool insideProxy = false;
+    bool uploadedOnce = false;
+    bool warnedOverflow = false;
+
+    GLuint instanceUbo = 0;
+    GLuint proxyVao = 0;                    // No attributes; the proxy corners come from gl_VertexID
+    GLuint triangle = 0;
+
+    // Cloud program handle, re-resolved when a different program is passed in
+    unsigned int programId = 0;
+    UniformHandle drawProxiesLoc;
+    UniformHandle proxyViewportLoc;
+};
+
+#endif // CLOUDSCENE_H
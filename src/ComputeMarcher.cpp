@@ -0,0 +1,70 @@
+#include "ComputeMarcher.h"
+#include "GLExtensions.h"
+#include <iostream>
+
+ComputeMarcher::~ComputeMarcher()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+}
+
+bool ComputeMarcher::supported()
+{
+    return GLExtensions::caps().computeShader;
+}
+
+void ComputeMarcher::setProgram(std::unique_ptr<Shader> computeProgram)
+{
+    program = std::move(computeProgram);
+}
+
+// (Re)creates the output image and its read framebuffer for a new viewport size
+void ComputeMarcher::resize(int newWidth, int newHeight)
+{
+    if (newWidth == width && newHeight == height) {
+        return;
+    }
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+    width = newWidth;
+    height = newHeight;
+
+    // Image load/store needs an immutable texture of the declared format (rgba16f);
+    // GL 4.3 always has texture storage
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error::ComputeMarcher::Framebuffer incomplete (" << width << "x" << height << ")" << std::endl;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previous);
+}
+
+void ComputeMarcher::draw()
+{
+    GLint viewport[4];
+    GLint target = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+    resize(viewport[2], viewport[3]);
+
+    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glDispatchCompute((GLuint)((width + kTileSize - 1) / kTileSize), (GLuint)((height + kTileSize - 1) / kTileSize), 1);
+    // The blit reads the image through a framebuffer
+    glMemoryBarrier(GL_FRAMEBUFFER_BARRIER_BIT);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)target);
+    glBlitFramebuffer(0, 0, width, height, viewport[0], viewport[1], viewport[0] + width, viewport[1] + height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)target);
+}
@@ -0,0 +1,46 @@
+#ifndef COMPUTEMARCHER_H
+#define COMPUTEMARCHER_H
+
+#include <memory>
+#include <glad/glad.h>
+#include "Shader.h"
+
+// GL 4.3 alternative to drawing the cloud pass with a full-screen triangle: a compute
+// program marches 8x8 tiles into an RGBA16F image and skips tiles whose rays cannot
+// reach the cloud. The image is then blitted into whatever FramePipeline bound, so the
+// temporal and scaled modes work the same for both paths.
+class ComputeMarcher
+{
+public:
+    // Must match local_size_x/y in cloud_compute_shader.glsl
+    static const int kTileSize = 8;
+
+    ComputeMarcher() = default;
+    ~ComputeMarcher();
+    ComputeMarcher(const ComputeMarcher&) = delete;
+    ComputeMarcher& operator=(const ComputeMarcher&) = delete;
+
+    // True if the context can run the compute path (GLCapabilities::computeShader)
+    static bool supported();
+
+    // Installs the compute program (cloud_compute_shader.glsl, already bound to the scene
+    // blocks and samplers)
+    void setProgram(std::unique_ptr<Shader> computeProgram);
+    // The installed program if it linked, otherwise null
+    Shader* activeProgram() const { return program && program->isValid() ? program.get() : nullptr; }
+
+    // Marches the current viewport with the bound program and blits the result into the
+    // bound draw framebuffer at the same viewport
+    void draw();
+
+private:
+    void resize(int newWidth, int newHeight);
+
+    std::unique_ptr<Shader> program;
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    int width = 0;
+    int height = 0;
+};
+
+#endif // COMPUTEMARCHER_H
@@ -0,0 +1,336 @@
+#include "CpuRenderer.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Constants of cloud_march.glsl
+    const float kSigmaS = 2.0f;
+    const float kSigmaA = 0.2f;
+    const float kBackground = 0.6f;
+    // mix(fogColor, lightColor, 0.3)
+    const glm::vec3 kScatterColor = glm::vec3(1.0f) * 0.7f + glm::vec3(1.0f, 0.7f, 0.5f) * 0.3f;
+
+    float smoothstep(float edge0, float edge1, float x)
+    {
+        float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    // GL_REPEAT texel index
+    int wrap(int i, int size)
+    {
+        i %= size;
+        return i < 0 ? i + size : i;
+    }
+
+    // Per-pixel value in [0, 1) (interleavedGradientNoise in cloud_march.glsl)
+    float interleavedGradientNoise(glm::vec2 pixel)
+    {
+        float f = pixel.x * 0.06711056f + pixel.y * 0.00583715f;
+        f -= std::floor(f);
+        f *= 52.9829189f;
+        return f - std::floor(f);
+    }
+
+    // Chord of a ray through a sphere (boundingChord in cloud_march.glsl); false on a miss
+    bool sphereChord(const glm::vec3& ro, const glm::vec3& rd, const Sphere& s, float& tNear, float& tFar)
+    {
+        glm::vec3 oc = ro - s.center;
+        float b = glm::dot(oc, rd);
+        float c2 = glm::dot(oc, oc) - s.radius * s.radius;
+        float det = b * b - c2;
+        if (det < 0.0f) {
+            return false;
+        }
+        float sqrtDet = std::sqrt(det);
+        tNear = std::max(-b - sqrtDet, 0.0f);
+        tFar = -b + sqrtDet;
+        return tFar >= 0.0f;
+    }
+}
+
+// Everything derived from the settings once per render
+struct CpuRenderer::Frame {
+    const Settings* settings;
+    std::vector<CloudInstance> instances;    // Front to back
+    std::vector<Sphere> instanceBounds;      // World-space bounding sphere of each
+    float cosA;                              // Noise rotation, iTime * 0.05
+    float sinA;
+};
+
+CpuRenderer::CpuRenderer(const SphereBVH& bvh, const Sphere& bounding)
+    : spheres(bvh), bounds(bounding)
+{
+}
+
+void CpuRenderer::setNoiseTexture(const unsigned char* texels, int width, int height)
+{
+    noise2D = texels;
+    noiseWidth = width;
+    noiseHeight = height;
+}
+
+void CpuRenderer::setNoiseVolume(const unsigned char* texels, int size)
+{
+    noise3D = texels;
+    volumeSize = size;
+}
+
+std::vector<unsigned char> CpuRenderer::render(const Settings& settings) const
+{
+    Frame frame;
+    frame.settings = &settings;
+    frame.instances = settings.instances;
+    // The GPU gets them sorted by CloudScene; the nearest point of the bounding sphere counts
+    auto distance = [&](const CloudInstance& instance) {
+        glm::vec3 center = instance.offset + instance.scale * bounds.center;
+        return glm::length(center - settings.camera.position) - instance.scale * bounds.radius;
+    };
+    std::stable_sort(frame.instances.begin(), frame.instances.end(),
+                     [&](const CloudInstance& a, const CloudInstance& b) { return distance(a) < distance(b); });
+    for (const CloudInstance& instance : frame.instances) {
+        frame.instanceBounds.push_back({ instance.offset + instance.scale * bounds.center, instance.scale * bounds.radius });
+    }
+    float angle = settings.time * 0.05f;
+    frame.cosA = std::cos(angle);
+    frame.sinA = std::sin(angle);
+
+    std::vector<unsigned char> rgb((size_t)settings.width * settings.height * 3);
+    int tilesX = (settings.width + kTileSize - 1) / kTileSize;
+    int tilesY = (settings.height + kTileSize - 1) / kTileSize;
+    // One tile per claim: tiles over the cloud cost far more than the empty ones
+    ThreadPool::shared().parallelFor(tilesX * tilesY, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            renderTile(frame, i % tilesX, i / tilesX, rgb.data());
+        }
+    });
+    return rgb;
+}
+
+void CpuRenderer::renderTile(const Frame& frame, int tileX, int tileY, unsigned char* rgb) const
+{
+    const Settings& s = *frame.settings;
+    const Camera& camera = s.camera;
+    int x0 = tileX * kTileSize;
+    int y0 = tileY * kTileSize;
+    int x1 = std::min(x0 + kTileSize, s.width);
+    int y1 = std::min(y0 + kTileSize, s.height);
+
+    alignas(32) float lane[simd::kLanes];
+    for (int y = y0; y < y1; y++) {
+        // y counts from the bottom like gl_FragCoord; the image is stored top row first
+        unsigned char* row = rgb + (size_t)(s.height - 1 - y) * s.width * 3;
+        float v = ((float)y + 0.5f) / (float)s.height * 2.0f - 1.0f;
+        glm::vec3 rowDir = camera.forward + v * camera.tanHalfFov.y * camera.up;
+
+        for (int x = x0; x < x1; x += simd::kLanes) {
+            // Packet of kLanes unnormalized rays: d = rowDir + u * tanX * right. A ray hits a
+            // sphere if the quadratic |o + t d - c|^2 = r^2 has a root t >= 0, i.e.
+            // det = b^2 - |d|^2 (|oc|^2 - r^2) >= 0 and -b + sqrt(det) >= 0 with b = oc.d.
+            for (int k = 0; k < simd::kLanes; k++) {
+                lane[k] = ((float)std::min(x + k, x1 - 1) + 0.5f) / (float)s.width * 2.0f - 1.0f;
+            }
+            simd::f32x8 u = simd::f32x8::load(lane) * simd::f32x8::set1(camera.tanHalfFov.x);
+            simd::f32x8 dx = simd::f32x8::set1(rowDir.x) + u * simd::f32x8::set1(camera.right.x);
+            simd::f32x8 dy = simd::f32x8::set1(rowDir.y) + u * simd::f32x8::set1(camera.right.y);
+            simd::f32x8 dz = simd::f32x8::set1(rowDir.z) + u * simd::f32x8::set1(camera.right.z);
+            simd::f32x8 dd = dx * dx + dy * dy + dz * dz;
+            simd::f32x8 hit = simd::f32x8::set1(-1.0f);
+            for (const Sphere& sphere : frame.instanceBounds) {
+                glm::vec3 oc = camera.position - sphere.center;
+                simd::f32x8 b = dx * simd::f32x8::set1(oc.x) + dy * simd::f32x8::set1(oc.y) + dz * simd::f32x8::set1(oc.z);
+                simd::f32x8 c = simd::f32x8::set1(glm::dot(oc, oc) - sphere.radius * sphere.radius);
+                simd::f32x8 det = b * b - dd * c;
+                simd::f32x8 far = simd::sqrt(simd::max(det, simd::f32x8::set1(0.0f))) - b;
+                // >= 0 exactly where this sphere is hit
+                hit = simd::max(hit, simd::min(det, far));
+            }
+            hit.store(lane);
+
+            for (int k = 0; k < simd::kLanes && x + k < x1; k++) {
+                glm::vec3 color(kBackground);
+                if (lane[k] >= 0.0f) {
+                    color = renderPixel(frame, glm::vec2((float)(x + k) + 0.5f, (float)y + 0.5f));
+                }
+                unsigned char* out = row + (size_t)(x + k) * 3;
+                for (int c = 0; c < 3; c++) {
+                    out[c] = (unsigned char)(std::min(std::max(color[c], 0.0f), 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+// renderCloud() for one pixel, without the depth output
+glm::vec3 CpuRenderer::renderPixel(const Frame& frame, glm::vec2 pixel) const
+{
+    const Settings& s = *frame.settings;
+    const Camera& camera = s.camera;
+    glm::vec2 uv = pixel / glm::vec2((float)s.width, (float)s.height) * 2.0f - 1.0f;
+    glm::vec3 ro = camera.position;
+    glm::vec3 rd = glm::normalize(camera.forward + uv.x * camera.tanHalfFov.x * camera.right +
+                                  uv.y * camera.tanHalfFov.y * camera.up);
+
+    glm::vec3 color(0.0f);
+    float transmittance = 1.0f;
+    float jitter = interleavedGradientNoise(pixel);
+    for (size_t i = 0; i < frame.instances.size() && transmittance >= 0.001f; i++) {
+        const CloudInstance& instance = frame.instances[i];
+        glm::vec3 localOrigin = (ro - instance.offset) / instance.scale;
+        float tNear, tFar;
+        if (!sphereChord(localOrigin, rd, bounds, tNear, tFar)) {
+            continue;
+        }
+        if (s.adaptive) {
+            marchAdaptive(frame, localOrigin, rd, tNear, tFar, jitter, color, transmittance);
+        } else {
+            marchFixed(frame, localOrigin, rd, tNear, tFar, color, transmittance);
+        }
+    }
+    return color + glm::vec3(kBackground) * transmittance;
+}
+
+// marchFixed() without the temporal jitter
+float CpuRenderer::marchFixed(const Frame& frame, const glm::vec3& ro, const glm::vec3& rd, float tNear, float tFar,
+                              glm::vec3& color, float& transmittance) const
+{
+    int steps = std::max(frame.settings->marchSteps, 1);
+    float marchStep = (tFar - tNear) / (float)steps;
+    float tHit = tFar;
+    for (int i = 0; i < steps; i++) {
+        float t = tNear + (float)i * marchStep;
+        glm::vec3 pos = ro + rd * t;
+
+        // Empty-space skipping: every sample closer than the distance bound is outside the cloud
+        float dist = cloudDistance(pos);
+        if (dist > 0.0f) {
+            i += std::max((int)std::ceil(dist / marchStep) - 1, 0);
+            continue;
+        }
+
+        float dens = noiseDensity(frame, pos);
+        if (dens > 0.001f) {
+            tHit = std::min(tHit, t);
+            if (!integrateSample(frame, pos, dens, marchStep, color, transmittance)) {
+                break;
+            }
+        }
+    }
+    return tHit;
+}
+
+float CpuRenderer::marchAdaptive(const Frame& frame, const glm::vec3& ro, const glm::vec3& rd, float tNear, float tFar,
+                                 float jitter, glm::vec3& color, float& transmittance) const
+{
+    int fineSteps = 2 * std::max(frame.settings->marchSteps, 1);
+    int maxIterations = 2 * fineSteps;
+    float fineStep = (tFar - tNear) / (float)fineSteps;
+
+    float t = tNear + fineStep * jitter;
+    float tHit = tFar;
+    for (int i = 0; i < maxIterations && t < tFar; i++) {
+        glm::vec3 pos = ro + rd * t;
+        float dist = cloudDistance(pos);
+        if (dist > 0.0f) {
+            // Never advance by less than a fine step, so grazing rays still terminate
+            t += std::max(dist, fineStep);
+            continue;
+        }
+
+        float dens = noiseDensity(frame, pos);
+        if (dens > 0.001f) {
+            tHit = std::min(tHit, t);
+            if (!integrateSample(frame, pos, dens, fineStep, color, transmittance)) {
+                break;
+            }
+        }
+        t += fineStep;
+    }
+    return tHit;
+}
+
+// Scattering and Beer-Lambert absorption of one sample; false once the ray is opaque
+bool CpuRenderer::integrateSample(const Frame& frame, const glm::vec3& pos, float dens, float stepLen,
+                                  glm::vec3& color, float& transmittance) const
+{
+    float shadow = shadowAt(frame, pos);
+    color += dens * kSigmaS * kScatterColor * shadow * transmittance * stepLen;
+    transmittance *= std::exp(-dens * (kSigmaA + kSigmaS) * stepLen);
+    return transmittance >= 0.001f;
+}
+
+// Light reaching pos: shadowSteps samples 0.05 apart towards the light
+float CpuRenderer::shadowAt(const Frame& frame, glm::vec3 pos) const
+{
+    float shadow = 1.0f;
+    for (int s = 0; s < frame.settings->shadowSteps; s++) {
+        pos += frame.settings->lightDir * 0.05f;
+        if (glm::length(pos - bounds.center) - bounds.radius > 0.0f) {
+            break;
+        }
+        float ds = cloudDensity(frame, pos);
+        if (ds > 0.02f) {
+            shadow *= std::exp(-ds * 0.3f);
+            if (shadow < 0.01f) {
+                break;
+            }
+        }
+    }
+    return shadow;
+}
+
+float CpuRenderer::cloudDensity(const Frame& frame, const glm::vec3& p) const
+{
+    if (cloudDistance(p) > 0.0f) {
+        return 0.0f;
+    }
+    return noiseDensity(frame, p);
+}
+
+// noiseDensity() with bilinear (2D) or trilinear (3D) filtering of the top mip level
+float CpuRenderer::noiseDensity(const Frame& frame, const glm::vec3& p) const
+{
+    glm::vec3 q(p.x * frame.cosA - p.z * frame.sinA, p.y, p.x * frame.sinA + p.z * frame.cosA);
+    q *= 0.1f;
+
+    float noiseVal = 0.0f;
+    if (frame.settings->useNoiseVolume && noise3D) {
+        // Texel centers sit at (i + 0.5) / size
+        glm::vec3 t = q * (float)volumeSize - 0.5f;
+        glm::vec3 base = glm::floor(t);
+        glm::vec3 f = t - base;
+        int ix = (int)base.x, iy = (int)base.y, iz = (int)base.z;
+        glm::vec4 n(0.0f);
+        for (int corner = 0; corner < 8; corner++) {
+            int cx = corner & 1, cy = (corner >> 1) & 1, cz = (corner >> 2) & 1;
+            float w = (cx ? f.x : 1.0f - f.x) * (cy ? f.y : 1.0f - f.y) * (cz ? f.z : 1.0f - f.z);
+            size_t index = ((size_t)(wrap(iz + cz, volumeSize) * volumeSize + wrap(iy + cy, volumeSize)) * volumeSize +
+                            wrap(ix + cx, volumeSize)) * 4;
+            const unsigned char* texel = noise3D + index;
+            n += w * glm::vec4(texel[0], texel[1], texel[2], texel[3]);
+        }
+        n /= 255.0f;
+        float detail = n.y * 0.625f + n.z * 0.25f + n.w * 0.125f;
+        noiseVal = std::min(std::max((n.x - detail * 0.35f) / (1.0f - detail * 0.35f), 0.0f), 1.0f);
+    } else if (noise2D) {
+        glm::vec2 t = glm::vec2(q.x * (float)noiseWidth, q.z * (float)noiseHeight) - 0.5f;
+        glm::vec2 base = glm::floor(t);
+        glm::vec2 f = t - base;
+        int ix = (int)base.x, iy = (int)base.y;
+        auto at = [&](int x, int y) {
+            return (float)noise2D[(size_t)wrap(y, noiseHeight) * noiseWidth + wrap(x, noiseWidth)];
+        };
+        float top = at(ix, iy) * (1.0f - f.x) + at(ix + 1, iy) * f.x;
+        float bottom = at(ix, iy + 1) * (1.0f - f.x) + at(ix + 1, iy + 1) * f.x;
+        noiseVal = (top * (1.0f - f.y) + bottom * f.y) / 255.0f;
+    }
+    return smoothstep(0.3f, 1.0f, noiseVal);
+}
+
+// sdCloud(): exact outside the cloud; the first sphere containing p ends the search
+float CpuRenderer::cloudDistance(const glm::vec3& p) const
+{
+    return spheres.signedDistance(p, 0.0f);
+}
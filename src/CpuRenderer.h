@@ -0,0 +1,72 @@
+#ifndef CPURENDERER_H
+#define CPURENDERER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Camera.h"
+#include "CloudScene.h"
+#include "Cloud.h"
+#include "SphereBVH.h"
+
+// C++ port of the cloud pass (renderCloud in cloud_march.glsl) for machines without a GPU.
+// It follows the reference path of the shader: the analytic BVH distance instead of the
+// baked SDF, and the per-sample shadow march instead of the light volume. Textures are
+// sampled bilinearly from their top level. The image is split into kTileSize tiles that
+// idle threads of ThreadPool::shared() claim one at a time. In every tile, rows of
+// simd::kLanes pixels are tested against the bounding spheres as one packet, so empty sky
+// costs almost nothing. The output does not depend on the thread count.
+class CpuRenderer
+{
+public:
+    static const int kTileSize = 16;
+
+    // What the GPU pass reads from SceneBlock, FrameBlock and its uniforms
+    struct Settings {
+        int width = 800;
+        int height = 600;
+        int marchSteps = 64;
+        int shadowSteps = 16;
+        bool adaptive = false;              // uMarchMode 1
+        bool useNoiseVolume = true;
+        float time = 0.0f;
+        glm::vec3 lightDir = glm::normalize(glm::vec3(1.0f, 1.0f, -0.3f));
+        Camera camera;
+        std::vector<CloudInstance> instances = { CloudInstance() };
+    };
+
+    // The noise data must stay alive while the renderer is used (e.g. the NoiseCache mappings)
+    CpuRenderer(const SphereBVH& bvh, const Sphere& bounding);
+    // Single-channel 2D noise (uNoiseTex)
+    void setNoiseTexture(const unsigned char* texels, int width, int height);
+    // RGBA8 Perlin-Worley volume (uNoiseVolume)
+    void setNoiseVolume(const unsigned char* texels, int size);
+
+    // Renders one frame as tightly packed RGB8 rows, top row first
+    std::vector<unsigned char> render(const Settings& settings) const;
+
+private:
+    struct Frame;
+
+    void renderTile(const Frame& frame, int tileX, int tileY, unsigned char* rgb) const;
+    glm::vec3 renderPixel(const Frame& frame, glm::vec2 pixel) const;
+    float marchFixed(const Frame& frame, const glm::vec3& ro, const glm::vec3& rd, float tNear, float tFar,
+                     glm::vec3& color, float& transmittance) const;
+    float marchAdaptive(const Frame& frame, const glm::vec3& ro, const glm::vec3& rd, float tNear, float tFar,
+                        float jitter, glm::vec3& color, float& transmittance) const;
+    bool integrateSample(const Frame& frame, const glm::vec3& pos, float dens, float stepLen,
+                         glm::vec3& color, float& transmittance) const;
+    float shadowAt(const Frame& frame, glm::vec3 pos) const;
+    float cloudDensity(const Frame& frame, const glm::vec3& p) const;
+    float noiseDensity(const Frame& frame, const glm::vec3& p) const;
+    float cloudDistance(const glm::vec3& p) const;
+
+    const SphereBVH& spheres;
+    Sphere bounds;
+    const unsigned char* noise2D = nullptr;
+    int noiseWidth = 0;
+    int noiseHeight = 0;
+    const unsigned char* noise3D = nullptr;
+    int volumeSize = 0;
+};
+
+#endif // CPURENDERER_H
@@ -0,0 +1,222 @@
+#include "FramePipeline.h"
+#include <iostream>
+
+namespace {
+    // Share of the history blended into a freshly marched pixel; averages the start jitter
+    // over several visits without smearing the slowly rotating noise for long
+    const float kHistoryWeight = 0.5f;
+
+    // Texture units used by the resolve and upsample passes, above the ones SceneUploader hands out
+    const int kUpsampleUnit = 13;
+    const int kMarchedUnit = 14;
+    const int kHistoryUnit = 15;
+
+    // Rounds a requested scale or cell size down to 1, 2 or 4
+    int clampMode(int value)
+    {
+        return value >= 4 ? 4 : value >= 2 ? 2 : 1;
+    }
+
+    // Order in which the pixels of a block are marched (ordered dithering), so that
+    // consecutive frames refresh pixels far apart. Entries are x + y * cell.
+    const int kOrder2[4] = { 0, 3, 1, 2 };
+    const int kOrder4[16] = { 0, 10, 2, 8, 5, 15, 7, 13, 1, 11, 3, 9, 4, 14, 6, 12 };
+}
+
+FramePipeline::FramePipeline(GLuint fullscreenTriangle)
+    : triangle(fullscreenTriangle)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+    release();
+}
+
+FramePipeline::Target FramePipeline::createTarget(int width, int height)
+{
+    Target target;
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    // Half floats so repeated blending does not stall on 8-bit rounding
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error::FramePipeline::Framebuffer incomplete (" << width << "x" << height << ")" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return target;
+}
+
+void FramePipeline::destroyTarget(Target& target)
+{
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteTextures(1, &target.texture);
+    target = Target{};
+}
+
+void FramePipeline::release()
+{
+    destroyTarget(marched);
+    for (Target& target : history) {
+        destroyTarget(target);
+    }
+    allocatedScale = allocatedCell = 0;
+    allocatedWidth = allocatedHeight = 0;
+    historyValid = false;
+}
+
+void FramePipeline::setResolveProgram(std::unique_ptr<Shader> program)
+{
+    resolve = std::move(program);
+    resolveCellLoc = resolve->uniform("uTemporalCell");
+    resolvePhaseLoc = resolve->uniform("uTemporalPhase");
+    resolveWeightLoc = resolve->uniform("uHistoryWeight");
+    resolve->use();
+    resolve->setInt("uMarched", kMarchedUnit);
+    resolve->setInt("uHistory", kHistoryUnit);
+}
+
+void FramePipeline::setUpsampleProgram(std::unique_ptr<Shader> program)
+{
+    upsample = std::move(program);
+    upsampleScaleLoc = upsample->uniform("uScale");
+    upsample->use();
+    upsample->setInt("uLowRes", kUpsampleUnit);
+}
+
+void FramePipeline::setTemporalCell(int newCell)
+{
+    cell = clampMode(newCell);
+}
+
+void FramePipeline::setRenderScale(int newScale)
+{
+    scale = clampMode(newScale);
+}
+
+void FramePipeline::setFramebufferSize(int newWidth, int newHeight)
+{
+    width = newWidth;
+    height = newHeight;
+    frameScale = upsample && upsample->isValid() ? scale : 1;
+    frameCell = resolve && resolve->isValid() ? cell : 1;
+    renderW = (width + frameScale - 1) / frameScale;
+    renderH = (height + frameScale - 1) / frameScale;
+    offscreen = frameScale > 1 || frameCell > 1;
+    if (offscreen) {
+        allocate();
+    }
+}
+
+void FramePipeline::allocate()
+{
+    if (allocatedWidth == width && allocatedHeight == height &&
+        allocatedScale == frameScale && allocatedCell == frameCell) {
+        return;
+    }
+    release();
+    marched = createTarget((renderW + frameCell - 1) / frameCell, (renderH + frameCell - 1) / frameCell);
+    for (Target& target : history) {
+        target = createTarget(renderW, renderH);
+    }
+    allocatedWidth = width;
+    allocatedHeight = height;
+    allocatedScale = frameScale;
+    allocatedCell = frameCell;
+}
+
+void FramePipeline::beginCloudPass(const Shader& cloud)
+{
+    if (cloud.ID != programId) {
+        programId = cloud.ID;
+        cellLoc = cloud.uniform("uTemporalCell");
+        phaseLoc = cloud.uniform("uTemporalPhase");
+        frameLoc = cloud.uniform("uFrameIndex");
+    }
+    frameIndex++;
+    cloud.setInt(frameLoc, (int)frameIndex);
+    resolvePending = false;
+
+    if (!offscreen) {
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        cloud.setInt(cellLoc, 1);
+        cloud.setInt(phaseLoc, 0);
+        return;
+    }
+
+    current = 1 - current;
+    if (frameCell == 1 || !historyValid) {
+        // Nothing to reuse: march every pixel straight into the new history
+        glBindFramebuffer(GL_FRAMEBUFFER, history[current].framebuffer);
+        glViewport(0, 0, renderW, renderH);
+        cloud.setInt(cellLoc, 1);
+        cloud.setInt(phaseLoc, 0);
+        historyValid = true;
+        return;
+    }
+
+    int cells = frameCell * frameCell;
+    phase = (frameCell == 4 ? kOrder4 : kOrder2)[frameIndex % cells];
+    glBindFramebuffer(GL_FRAMEBUFFER, marched.framebuffer);
+    glViewport(0, 0, (renderW + frameCell - 1) / frameCell, (renderH + frameCell - 1) / frameCell);
+    cloud.setInt(cellLoc, frameCell);
+    cloud.setInt(phaseLoc, phase);
+    resolvePending = true;
+}
+
+void FramePipeline::endCloudPass()
+{
+    if (!offscreen) {
+        return;
+    }
+
+    if (resolvePending) {
+        glBindFramebuffer(GL_FRAMEBUFFER, history[current].framebuffer);
+        glViewport(0, 0, renderW, renderH);
+        glActiveTexture(GL_TEXTURE0 + kMarchedUnit);
+        glBindTexture(GL_TEXTURE_2D, marched.texture);
+        glActiveTexture(GL_TEXTURE0 + kHistoryUnit);
+        glBindTexture(GL_TEXTURE_2D, history[1 - current].texture);
+        resolve->use();
+        resolve->setInt(resolveCellLoc, frameCell);
+        resolve->setInt(resolvePhaseLoc, phase);
+        resolve->setFloat(resolveWeightLoc, kHistoryWeight);
+        glBindVertexArray(triangle);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        resolvePending = false;
+    }
+
+    present();
+}
+
+void FramePipeline::present()
+{
+    if (frameScale == 1) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, history[current].framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, output);
+        glViewport(0, 0, width, height);
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, output);
+    glViewport(0, 0, width, height);
+    glActiveTexture(GL_TEXTURE0 + kUpsampleUnit);
+    glBindTexture(GL_TEXTURE_2D, history[current].texture);
+    upsample->use();
+    upsample->setInt(upsampleScaleLoc, frameScale);
+    glBindVertexArray(triangle);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+}
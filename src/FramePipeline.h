@@ -0,0 +1,111 @@
+#ifndef FRAMEPIPELINE_H
+#define FRAMEPIPELINE_H
+
+#include <memory>
+#include <glad/glad.h>
+#include "Shader.h"
+
+// Render targets between the cloud pass and the output framebuffer (the default one unless set).
+// With a render scale of 2 or 4 the cloud is marched at 1/scale of the framebuffer size
+// and a depth-aware upsample pass fills the framebuffer; the cloud pass writes the
+// normalized distance of its first dense sample to alpha for that.
+// In temporal mode the cloud pass runs at 1/cell of the resolution and each fragment
+// marches one pixel of its cell x cell block with a fresh jitter, so a frame marches
+// 1/4 or 1/16 of the pixels. A resolve pass scatters them into a full-resolution
+// history and carries the other pixels over from the previous frame. Only the noise moves
+// (slowly) while the camera stands still, so previous pixels are reused in place; moving
+// the camera resets the history.
+class FramePipeline
+{
+public:
+    // fullscreenTriangle is a VAO drawing one triangle that covers the viewport
+    explicit FramePipeline(GLuint fullscreenTriangle);
+    ~FramePipeline();
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Installs the temporal resolve program (temporal_resolve_shader.glsl)
+    void setResolveProgram(std::unique_ptr<Shader> program);
+    // Installs the depth-aware upsample program (upsample_shader.glsl)
+    void setUpsampleProgram(std::unique_ptr<Shader> program);
+
+    // 1 marches at the framebuffer size; 2 and 4 at half and a quarter of it per axis
+    void setRenderScale(int scale);
+    int renderScale() const { return scale; }
+
+    // 1 draws every pixel straight to the output framebuffer; 2 and 4 march 1/4 and
+    // 1/16 of the pixels per frame and reuse the history for the rest
+    void setTemporalCell(int cell);
+    int temporalCell() const { return cell; }
+    // Drops the history so the next frame marches every pixel, e.g. after the
+    // camera or the render settings changed
+    void resetHistory() { historyValid = false; }
+
+    // Framebuffer the finished image goes to; 0 (the default framebuffer) unless rendering offscreen
+    void setOutputFramebuffer(GLuint framebuffer) { output = framebuffer; }
+
+    // Sizes the targets for this frame's framebuffer, reallocating only when the size or
+    // the modes changed. Call once per frame before writing iResolution.
+    void setFramebufferSize(int width, int height);
+    // Size the cloud pass marches at (iResolution); the framebuffer size divided by the scale
+    int renderWidth() const { return renderW; }
+    int renderHeight() const { return renderH; }
+
+    // Binds the cloud pass target and viewport and sets the temporal uniforms on the
+    // bound cloud program
+    void beginCloudPass(const Shader& cloud);
+    // Resolves the cloud pass into the history and shows it on the output framebuffer,
+    // upsampled if needed. Leaves the output framebuffer and its full viewport bound.
+    void endCloudPass();
+
+private:
+    struct Target {
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+    };
+
+    static Target createTarget(int width, int height);
+    static void destroyTarget(Target& target);
+    void allocate();
+    void release();
+    void present();
+
+    GLuint triangle = 0;
+    GLuint output = 0;
+    std::unique_ptr<Shader> resolve;
+    UniformHandle resolveCellLoc;
+    UniformHandle resolvePhaseLoc;
+    UniformHandle resolveWeightLoc;
+    std::unique_ptr<Shader> upsample;
+    UniformHandle upsampleScaleLoc;
+
+    Target marched;                     // Cloud pass output at 1/cell of the render size
+    Target history[2];                  // Full frames at the render size
+    int current = 0;                    // History written this frame; the other one is read
+    int width = 0;                      // Framebuffer size
+    int height = 0;
+    int renderW = 0;
+    int renderH = 0;
+    int scale = 1;
+    int cell = 1;
+    // Modes in effect this frame: the requested ones, or 1 while their program is missing
+    int frameScale = 1;
+    int frameCell = 1;
+    int allocatedScale = 0;             // Modes and size the targets were created for
+    int allocatedCell = 0;
+    int allocatedWidth = 0;
+    int allocatedHeight = 0;
+    int phase = 0;
+    unsigned frameIndex = 0;
+    bool historyValid = false;
+    bool offscreen = false;             // This frame's cloud pass goes to the targets above
+    bool resolvePending = false;        // ... and to `marched` rather than straight into the history
+
+    // Cloud program handles, re-resolved when a different program is passed in
+    unsigned int programId = 0;
+    UniformHandle cellLoc;
+    UniformHandle phaseLoc;
+    UniformHandle frameLoc;
+};
+
+#endif // FRAMEPIPELINE_H
@@ -0,0 +1,275 @@
+#include "FrameRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+    bool endsWith(const std::string& s, const std::string& suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // BT.601 limited range, what ffmpeg assumes for a Y4M stream without color tags
+    unsigned char lumaOf(int r, int g, int b) { return (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+    unsigned char cbOf(int r, int g, int b) { return (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+    unsigned char crOf(int r, int g, int b) { return (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+
+    // Starts ffmpeg reading a Y4M stream on its stdin and encoding to `path`. It is spawned
+    // directly with an argument vector, not through a shell, so the path is never parsed.
+    // Returns the write end of its stdin, or nullptr with `pid` left at -1.
+    FILE* spawnEncoder(const std::string& path, pid_t& pid)
+    {
+        pid = -1;
+        int fds[2];
+        if (pipe(fds) != 0) {
+            return nullptr;
+        }
+        // The write end must not leak into ffmpeg, or it never sees the end of its input
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+        if (fds[0] != STDIN_FILENO) {
+            posix_spawn_file_actions_addclose(&actions, fds[0]);
+        }
+        // Through the file protocol a relative path starting with '-' is not read as an option
+        std::string output = path[0] == '/' ? path : "file:" + path;
+        char* argv[] = { (char*)"ffmpeg", (char*)"-y", (char*)"-loglevel", (char*)"error", (char*)"-f",
+                         (char*)"yuv4mpegpipe", (char*)"-i", (char*)"-", &output[0], nullptr };
+        // ffmpeg gets the default SIGPIPE even while the recorder ignores it
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        sigset_t defaults;
+        sigemptyset(&defaults);
+        sigaddset(&defaults, SIGPIPE);
+        posix_spawnattr_setsigdefault(&attributes, &defaults);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF);
+        bool spawned = posix_spawnp(&pid, "ffmpeg", &actions, &attributes, argv, environ) == 0;
+        posix_spawnattr_destroy(&attributes);
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[0]);
+        if (!spawned) {
+            pid = -1;
+            close(fds[1]);
+            return nullptr;
+        }
+
+        FILE* stream = fdopen(fds[1], "wb");
+        if (!stream) {
+            close(fds[1]);
+            waitpid(pid, nullptr, 0);
+            pid = -1;
+        }
+        return stream;
+    }
+}
+
+FrameRecorder::FrameRecorder(const std::string& path, int fps)
+    : target(path), rate(std::max(fps, 1))
+{
+    if (endsWith(path, ".y4m")) {
+        out = std::fopen(path.c_str(), "wb");
+    } else {
+        out = spawnEncoder(path, encoder);
+        if (out) {
+            // A failed encoder then shows up as a write error instead of killing the process;
+            // finish() puts the previous handler back
+            struct sigaction ignore = {};
+            ignore.sa_handler = SIG_IGN;
+            sigemptyset(&ignore.sa_mask);
+            sigaction(SIGPIPE, &ignore, &previousSigpipe);
+        }
+    }
+    if (!out) {
+        std::cerr << "Error::FrameRecorder::Failed to open " << path << std::endl;
+        return;
+    }
+
+    for (Slot& slot : ring) {
+        glGenBuffers(1, &slot.pbo);
+    }
+    writer = std::thread([this]() { writeLoop(); });
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    finish();
+}
+
+void FrameRecorder::capture(GLuint framebuffer, int frameWidth, int frameHeight)
+{
+    if (!out) {
+        return;
+    }
+    if (width == 0) {
+        width = frameWidth;
+        height = frameHeight;
+    }
+    if (frameWidth != width || frameHeight != height) {
+        if (!warnedSize) {
+            std::cerr << "Error::FrameRecorder::Frame size changed to " << frameWidth << "x" << frameHeight
+                      << ", recording stays at " << width << "x" << height << " and skips these frames" << std::endl;
+            warnedSize = true;
+        }
+        return;
+    }
+
+    Slot& slot = ring[next];
+    if (slot.fence) {
+        retire(slot);
+        inFlight.pop_front();
+    }
+
+    // RGBA rows are 4-byte aligned and match the framebuffer, so the copy stays on the GPU
+    GLsizeiptr bytes = (GLsizeiptr)width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    if (framebuffer == 0) {
+        glReadBuffer(GL_BACK);
+    }
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    inFlight.push_back(next);
+    next = (next + 1) % kRingSize;
+    captured++;
+}
+
+// Copies a finished readback out of its buffer and queues it for the writer
+void FrameRecorder::retire(Slot& slot)
+{
+    if (glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+        stalls++;
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    std::vector<unsigned char> frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // Back-pressure instead of dropping frames: a slow encoder slows the loop down
+        if ((int)queued.size() >= kMaxQueued) {
+            stalls++;
+            drained.wait(lock, [this]() { return (int)queued.size() < kMaxQueued; });
+        }
+        if (!spare.empty()) {
+            frame = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    size_t bytes = (size_t)width * height * 4;
+    frame.resize(bytes);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)bytes, GL_MAP_READ_BIT)) {
+        std::memcpy(frame.data(), pixels, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(frame));
+    }
+    wake.notify_one();
+}
+
+void FrameRecorder::finish()
+{
+    if (!out) {
+        return;
+    }
+    while (!inFlight.empty()) {
+        retire(ring[inFlight.front()]);
+        inFlight.pop_front();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    bool closed = std::fclose(out) == 0;
+    out = nullptr;
+    if (encoder != -1) {
+        int status = 0;
+        closed = waitpid(encoder, &status, 0) == encoder && WIFEXITED(status) && WEXITSTATUS(status) == 0 && closed;
+        encoder = -1;
+        sigaction(SIGPIPE, &previousSigpipe, nullptr);
+    }
+    for (Slot& slot : ring) {
+        glDeleteBuffers(1, &slot.pbo);
+    }
+    if (writeFailed || !closed) {
+        std::cerr << "Error::FrameRecorder::Failed to write " << target << std::endl;
+        return;
+    }
+    std::cout << "Recorded " << captured << " frames at " << rate << " fps to " << target << " (" << stalls
+              << " stalled captures)" << std::endl;
+}
+
+void FrameRecorder::writeLoop()
+{
+    std::vector<unsigned char> planes;
+    bool headerWritten = false;
+    while (true) {
+        std::vector<unsigned char> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queued.empty(); });
+            if (queued.empty()) {
+                return;
+            }
+            frame = std::move(queued.front());
+            queued.pop_front();
+        }
+        drained.notify_one();
+
+        if (!writeFailed) {
+            if (!headerWritten) {
+                // Progressive, square pixels, full 4:4:4 chroma so odd sizes need no padding
+                std::fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, rate);
+                headerWritten = true;
+            }
+            writeFrame(frame, planes);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(frame));
+    }
+}
+
+// One Y4M frame: the Y, Cb and Cr planes, top row first (GL rows start at the bottom)
+void FrameRecorder::writeFrame(const std::vector<unsigned char>& rgba, std::vector<unsigned char>& planes)
+{
+    size_t count = (size_t)width * height;
+    planes.resize(count * 3);
+    unsigned char* y = planes.data();
+    unsigned char* cb = y + count;
+    unsigned char* cr = cb + count;
+    for (int row = 0; row < height; row++) {
+        const unsigned char* src = rgba.data() + (size_t)(height - 1 - row) * width * 4;
+        size_t dst = (size_t)row * width;
+        for (int x = 0; x < width; x++, src += 4) {
+            y[dst + x] = lumaOf(src[0], src[1], src[2]);
+            cb[dst + x] = cbOf(src[0], src[1], src[2]);
+            cr[dst + x] = crOf(src[0], src[1], src[2]);
+        }
+    }
+    if (std::fputs("FRAME\n", out) < 0 || std::fwrite(planes.data(), 1, planes.size(), out) != planes.size()) {
+        writeFailed = true;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef FRAMERECORDER_H
+#define FRAMERECORDER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/types.h>
+#include <glad/glad.h>
+
+// Streams the presented frames to disk without stalling the render loop (--record).
+// Each frame is read into one of kRingSize pixel-pack buffers; its glReadPixels only
+// queues a copy on the GPU. The buffer is mapped kRingSize frames later behind a fence,
+// when the copy has long finished, and its rows are handed to a writer thread that
+// converts them to YUV 4:4:4 and writes a Y4M stream: to the file itself for a .y4m
+// path, otherwise through a pipe into ffmpeg, which encodes by the path's extension.
+class FrameRecorder
+{
+public:
+    static const int kRingSize = 3;         // Frames between a readback and its map
+    static const int kMaxQueued = 8;        // Frames waiting for the writer before capture() blocks
+
+    FrameRecorder(const std::string& path, int fps);
+    ~FrameRecorder();
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // False if the output could not be opened
+    bool valid() const { return out != nullptr; }
+    int fps() const { return rate; }
+    // Frames captured so far; frame i shows time i / fps()
+    int frameCount() const { return captured; }
+
+    // Queues the readback of `framebuffer`'s color buffer and retires the frame captured
+    // kRingSize frames earlier. The video takes the size of the first frame; frames of
+    // another size are skipped.
+    void capture(GLuint framebuffer, int width, int height);
+    // Retires the frames still in flight, waits for the writer and closes the output
+    void finish();
+
+private:
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+    };
+
+    void retire(Slot& slot);
+    void writeLoop();
+    void writeFrame(const std::vector<unsigned char>& rgba, std::vector<unsigned char>& planes);
+
+    std::string target;
+    int rate;
+    FILE* out = nullptr;
+    pid_t encoder = -1;                     // ffmpeg writing the video from out, if any
+    struct sigaction previousSigpipe = {};  // Restored once the encoder is gone
+    int width = 0;                          // Video size, set by the first frame
+    int height = 0;
+    int captured = 0;
+    int stalls = 0;                         // Captures that had to wait for the GPU or the writer
+    bool warnedSize = false;
+
+    Slot ring[kRingSize];
+    int next = 0;                           // Slot of the next capture
+    std::deque<int> inFlight;               // Slots with a pending readback, oldest first
+
+    // Writer hand-off; `spare` recycles frame buffers so steady state does not allocate
+    std::mutex mutex;
+    std::condition_variable wake;           // New frame queued, or stopping
+    std::condition_variable drained;        // The writer took a frame
+    std::deque<std::vector<unsigned char>> queued;
+    std::vector<std::vector<unsigned char>> spare;
+    bool stopping = false;
+    bool writeFailed = false;
+    std::thread writer;
+};
+
+#endif // FRAMERECORDER_H
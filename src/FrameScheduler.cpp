@@ -0,0 +1,48 @@
+#include "FrameScheduler.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <thread>
+
+namespace {
+    // Left to spinning before a deadline; covers the usual sleep overshoot
+    const auto kSpinMargin = std::chrono::microseconds(1500);
+}
+
+FrameScheduler::FrameScheduler(int swapInterval, double maxFps)
+    : interval(std::max(swapInterval, 0)), fpsCap(maxFps)
+{
+    if (fpsCap > 0.0) {
+        period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fpsCap));
+    }
+}
+
+void FrameScheduler::apply() const
+{
+    glfwSwapInterval(interval);
+}
+
+void FrameScheduler::waitForNextFrame()
+{
+    if (fpsCap <= 0.0) {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    if (!started) {
+        deadline = now;
+        started = true;
+        return;
+    }
+    // Deadlines advance by whole periods so the average rate is exact; after a long
+    // frame the schedule restarts instead of rushing the following frames
+    deadline += period;
+    if (deadline < now) {
+        deadline = now;
+        return;
+    }
+    if (deadline - now > kSpinMargin) {
+        std::this_thread::sleep_until(deadline - kSpinMargin);
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <chrono>
+
+// Frame pacing of the interactive loop: the swap interval of the window's context and an
+// optional frame-rate cap. The cap sleeps through most of the wait and spins only for the
+// last part, since sleep_until alone can overshoot by a scheduler tick; it keeps the
+// frame period steady and the CPU idle between frames when vsync is off.
+class FrameScheduler
+{
+public:
+    // swapInterval: screen refreshes per buffer swap, 0 = no vsync; maxFps <= 0 = no cap
+    FrameScheduler(int swapInterval, double maxFps);
+
+    // Applies the swap interval to the current context
+    void apply() const;
+    // Call once per frame after the swap; returns when the next frame may start
+    void waitForNextFrame();
+
+    int swapInterval() const { return interval; }
+    double maxFps() const { return fpsCap; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int interval;
+    double fpsCap;
+    Clock::duration period{};
+    Clock::time_point deadline{};
+    bool started = false;
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,102 @@
+#include "GLExtensions.h"
+#include <cstring>
+
+#ifndef GL_VERSION_4_1
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = nullptr;
+#endif
+#ifndef GL_VERSION_4_2
+PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D = nullptr;
+PFNGLTEXSTORAGE3DPROC glad_glTexStorage3D = nullptr;
+PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture = nullptr;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = nullptr;
+#endif
+#ifndef GL_VERSION_4_3
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = nullptr;
+#endif
+#ifndef GL_VERSION_4_4
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+#endif
+#ifndef GL_KHR_parallel_shader_compile
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = nullptr;
+#endif
+
+namespace {
+    GLCapabilities capabilities;
+}
+
+void GLExtensions::load(GLADloadproc loader)
+{
+    capabilities = GLCapabilities();
+    glGetIntegerv(GL_MAJOR_VERSION, &capabilities.major);
+    glGetIntegerv(GL_MINOR_VERSION, &capabilities.minor);
+
+#ifndef GL_VERSION_4_1
+    glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)loader("glGetProgramBinary");
+    glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC)loader("glProgramBinary");
+    glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)loader("glProgramParameteri");
+#endif
+#ifndef GL_VERSION_4_2
+    glad_glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)loader("glTexStorage2D");
+    glad_glTexStorage3D = (PFNGLTEXSTORAGE3DPROC)loader("glTexStorage3D");
+    glad_glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)loader("glBindImageTexture");
+    glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)loader("glMemoryBarrier");
+#endif
+#ifndef GL_VERSION_4_3
+    glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)loader("glDispatchCompute");
+#endif
+#ifndef GL_VERSION_4_4
+    glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)loader("glBufferStorage");
+#endif
+#ifndef GL_KHR_parallel_shader_compile
+    glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)loader("glMaxShaderCompilerThreadsKHR");
+    if (!glad_glMaxShaderCompilerThreadsKHR) {
+        glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)loader("glMaxShaderCompilerThreadsARB");
+    }
+#endif
+
+    // A non-null pointer is not enough: some drivers export entry points they do not support
+    capabilities.textureStorage = glTexStorage2D && glTexStorage3D &&
+                                  (version(4, 2) || has("GL_ARB_texture_storage"));
+    capabilities.bufferStorage = glBufferStorage && (version(4, 4) || has("GL_ARB_buffer_storage"));
+    capabilities.computeShader = glDispatchCompute && glBindImageTexture && glMemoryBarrier && version(4, 3);
+
+    GLint binaryFormats = 0;
+    if (glGetProgramBinary && glProgramBinary && glProgramParameteri &&
+        (version(4, 1) || has("GL_ARB_get_program_binary"))) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    }
+    // macOS and some drivers report zero formats, which means binaries cannot be retrieved
+    capabilities.programBinary = binaryFormats > 0;
+
+    capabilities.parallelShaderCompile = glMaxShaderCompilerThreadsKHR &&
+        (has("GL_KHR_parallel_shader_compile") || has("GL_ARB_parallel_shader_compile"));
+    if (capabilities.parallelShaderCompile) {
+        // Let the driver pick as many compiler threads as it likes
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    }
+}
+
+const GLCapabilities& GLExtensions::caps()
+{
+    return capabilities;
+}
+
+bool GLExtensions::has(const char* extension)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (name && std::strcmp(name, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GLExtensions::version(int major, int minor)
+{
+    return capabilities.major > major || (capabilities.major == major && capabilities.minor >= minor);
+}
@@ -0,0 +1,92 @@
+#ifndef GLEXTENSIONS_H
+#define GLEXTENSIONS_H
+
+#include <glad/glad.h>
+
+// Entry points and enums newer than the GL 3.3 core profile that glad is generated for.
+// They are resolved at runtime and may be null; check GLExtensions::caps() before use.
+// Each block is skipped if glad is ever regenerated for a newer version.
+
+#ifndef GL_VERSION_4_1
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glad_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri;
+#define glGetProgramBinary glad_glGetProgramBinary
+#define glProgramBinary glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+#endif
+
+#ifndef GL_VERSION_4_2
+#define GL_TEXTURE_IMMUTABLE_FORMAT 0x912F
+#define GL_FRAMEBUFFER_BARRIER_BIT 0x00000400
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+typedef void (APIENTRYP PFNGLBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+extern PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D;
+extern PFNGLTEXSTORAGE3DPROC glad_glTexStorage3D;
+extern PFNGLBINDIMAGETEXTUREPROC glad_glBindImageTexture;
+extern PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier;
+#define glTexStorage2D glad_glTexStorage2D
+#define glTexStorage3D glad_glTexStorage3D
+#define glBindImageTexture glad_glBindImageTexture
+#define glMemoryBarrier glad_glMemoryBarrier
+#endif
+
+#ifndef GL_VERSION_4_3
+#define GL_COMPUTE_SHADER 0x91B9
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+extern PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute;
+#define glDispatchCompute glad_glDispatchCompute
+#endif
+
+#ifndef GL_VERSION_4_4
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+#endif
+
+// KHR_parallel_shader_compile (also exposed as the ARB variant with the same enums)
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+#endif
+
+// Optional features of the current context, filled in by GLExtensions::load()
+struct GLCapabilities {
+    int major = 3;
+    int minor = 3;
+    bool textureStorage = false;  // GL 4.2 / ARB_texture_storage: immutable textures
+    bool bufferStorage = false;   // GL 4.4 / ARB_buffer_storage: persistently mapped buffers
+    bool programBinary = false;   // GL 4.1 / ARB_get_program_binary with at least one binary format
+    bool parallelShaderCompile = false; // KHR/ARB_parallel_shader_compile: non-blocking compile and link
+    bool computeShader = false;   // GL 4.3: compute shaders with image load/store
+};
+
+class GLExtensions {
+public:
+    // Resolves the entry points above; call once after gladLoadGLLoader with the same loader
+    static void load(GLADloadproc loader);
+    static const GLCapabilities& caps();
+    // True if the context advertises the named extension
+    static bool has(const char* extension);
+    // True if the context version is at least major.minor
+    static bool version(int major, int minor);
+};
+
+#endif // GLEXTENSIONS_H
@@ -0,0 +1,89 @@
+#include "GpuNoise.h"
+#include "GLExtensions.h"
+#include <iostream>
+
+namespace {
+    const char* kNoiseShaderPath = "Shader/noise_compute_shader.glsl";
+}
+
+bool GpuNoise::supported()
+{
+    return GLExtensions::caps().computeShader;
+}
+
+GpuNoise::GpuNoise()
+    : perlinProgram(std::make_unique<Shader>(kNoiseShaderPath, true)),
+      volumeProgram(std::make_unique<Shader>(kNoiseShaderPath, true, Shader::Defines{ "NOISE_VOLUME" }))
+{
+    glGenBuffers(1, &permutationBuffer);
+    glGenTextures(1, &permutationTexture);
+}
+
+GpuNoise::~GpuNoise()
+{
+    glDeleteTextures(1, &permutationTexture);
+    glDeleteBuffers(1, &permutationBuffer);
+}
+
+bool GpuNoise::prepare(Shader& program, int seed)
+{
+    program.wait();
+    if (!program.isValid()) {
+        std::cerr << "Error::GpuNoise::" << kNoiseShaderPath << " did not link" << std::endl;
+        return false;
+    }
+    if (!hasPermutation || seed != permutationSeed) {
+        // Same table as the CPU generators build for this seed
+        PerlinNoise perlin(seed);
+        glBindBuffer(GL_TEXTURE_BUFFER, permutationBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, 512, perlin.permutation(), GL_STATIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, permutationTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, permutationBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        hasPermutation = true;
+        permutationSeed = seed;
+    }
+    program.use();
+    program.setInt("uPermutation", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, permutationTexture);
+    return true;
+}
+
+bool GpuNoise::generatePerlinTexture(GLuint texture, int width, int height, int seed)
+{
+    if (!prepare(*perlinProgram, seed)) {
+        return false;
+    }
+    perlinProgram->setInt("uWidth", width);
+    perlinProgram->setInt("uHeight", height);
+    perlinProgram->setFloat("uFrequency", (float)Noise::kTextureFrequency);
+    glBindImageTexture(0, texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+    glDispatchCompute((GLuint)((width + kTileSize - 1) / kTileSize), (GLuint)((height + kTileSize - 1) / kTileSize), 1);
+    // The texels are read by glGenerateMipmap and by sampling
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return true;
+}
+
+bool GpuNoise::generatePerlinWorleyVolume(GLuint texture, int size, int seed, const NoiseVolumeParams& params)
+{
+    if (!prepare(*volumeProgram, seed)) {
+        return false;
+    }
+    volumeProgram->setInt("uWidth", size);
+    volumeProgram->setInt("uHeight", size);
+    volumeProgram->setInt("uDepth", size);
+    volumeProgram->setInt("uBaseFrequency", params.baseFrequency);
+    volumeProgram->setInt("uOctaves", params.octaves);
+    volumeProgram->setFloat("uGain", params.gain);
+    volumeProgram->setInt("uWorleySeed", (int)Noise::worleySeed(seed));
+    // Layered, so every z slice of level 0 is bound
+    glBindImageTexture(0, texture, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    GLuint groups = (GLuint)((size + kVolumeTileSize - 1) / kVolumeTileSize);
+    glDispatchCompute(groups, groups, groups);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return true;
+}
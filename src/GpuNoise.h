@@ -0,0 +1,47 @@
+#ifndef GPUNOISE_H
+#define GPUNOISE_H
+
+#include <memory>
+#include <glad/glad.h>
+#include "Noise.h"
+#include "Shader.h"
+
+// Compute-shader backend of the noise generators (--noise gpu, GL 4.3). It writes the
+// same texels as Noise::generatePerlinNoiseTexture and Noise::generatePerlinWorleyVolume
+// straight into a texture, so setup neither generates nor copies them on the CPU. The
+// seed builds the same PerlinNoise permutation, which is handed to the shader as a
+// texture buffer, and the shader repeats the double-precision reference arithmetic.
+class GpuNoise
+{
+public:
+    // Must match local_size in noise_compute_shader.glsl
+    static const int kTileSize = 8;
+    static const int kVolumeTileSize = 4;
+
+    // True if the context can run the compute programs (GLCapabilities::computeShader)
+    static bool supported();
+
+    // Starts compiling both programs; they are waited for on first use
+    GpuNoise();
+    ~GpuNoise();
+    GpuNoise(const GpuNoise&) = delete;
+    GpuNoise& operator=(const GpuNoise&) = delete;
+
+    // Fills level 0 of an immutable R8 texture of width x height
+    bool generatePerlinTexture(GLuint texture, int width, int height, int seed);
+    // Fills level 0 of an immutable RGBA8 size^3 texture
+    bool generatePerlinWorleyVolume(GLuint texture, int size, int seed, const NoiseVolumeParams& params);
+
+private:
+    // Waits for the program and uploads the permutation of `seed` if it is a new one
+    bool prepare(Shader& program, int seed);
+
+    std::unique_ptr<Shader> perlinProgram;
+    std::unique_ptr<Shader> volumeProgram;
+    GLuint permutationBuffer = 0;
+    GLuint permutationTexture = 0;
+    bool hasPermutation = false;
+    int permutationSeed = 0;
+};
+
+#endif // GPUNOISE_H
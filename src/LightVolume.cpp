@@ -0,0 +1,132 @@
+#include "LightVolume.h"
+#include "GLExtensions.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+LightVolume::LightVolume(int resolution, GLuint fullscreenTriangle)
+    : triangle(fullscreenTriangle), size(resolution)
+{
+    glGenTextures(2, textures);
+    for (GLuint texture : textures) {
+        glBindTexture(GL_TEXTURE_3D, texture);
+        if (GLExtensions::caps().textureStorage) {
+            glTexStorage3D(GL_TEXTURE_3D, 1, GL_R8, size, size, size);
+        } else {
+            glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, size, size, size, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textures[0], 0, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Error::LightVolume::Framebuffer incomplete, falling back to the shadow march" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previous);
+}
+
+LightVolume::~LightVolume()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(2, textures);
+}
+
+void LightVolume::setProgram(std::unique_ptr<Shader> bakeProgram)
+{
+    program = std::move(bakeProgram);
+    sliceLoc = program->uniform("uSlice");
+    sizeLoc = program->uniform("uVolumeSize");
+    useNoiseVolumeLoc = program->uniform("uUseNoiseVolume");
+    useSdfVolumeLoc = program->uniform("uUseSdfVolume");
+    dirty = true;
+    baking = false;
+}
+
+bool LightVolume::needsBake(const Inputs& inputs) const
+{
+    if (dirty) {
+        return true;
+    }
+    if (inputs.lightDir != baked.lightDir || inputs.sceneHash != baked.sceneHash ||
+        inputs.useNoiseVolume != baked.useNoiseVolume || inputs.useSdfVolume != baked.useSdfVolume ||
+        inputs.shadowSteps != baked.shadowSteps) {
+        return true;
+    }
+    return std::fabs(inputs.time - baked.time) * 0.05f > kMaxAngleDrift;
+}
+
+bool LightVolume::update(const Inputs& inputs)
+{
+    if (!program || !program->isValid()) {
+        return false;
+    }
+    if (!baking) {
+        if (!needsBake(inputs)) {
+            return false;
+        }
+        pending = inputs;
+        nextSlice = 0;
+        baking = true;
+    }
+
+    // Without a previous bake to show, the whole volume is baked at once
+    int last = dirty ? size : std::min(nextSlice + kSlicesPerUpdate, size);
+    bakeSlices(nextSlice, last);
+    nextSlice = last;
+    if (nextSlice < size) {
+        return false;
+    }
+    front = 1 - front;
+    baked = pending;
+    baking = false;
+    dirty = false;
+    return true;
+}
+
+// Renders slices [first, last) of the back texture with the pending inputs
+void LightVolume::bakeSlices(int first, int last)
+{
+    GLint viewport[4];
+    GLint previous = 0;
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, size, size);
+    program->use();
+    program->setInt(sizeLoc, size);
+    program->setBool(useNoiseVolumeLoc, pending.useNoiseVolume);
+    program->setBool(useSdfVolumeLoc, pending.useSdfVolume);
+    glBindVertexArray(triangle);
+    // One full-screen triangle per slice; each fragment is one texel of that layer
+    for (int z = first; z < last; z++) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textures[1 - front], 0, z);
+        program->setInt(sliceLoc, z);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glBindVertexArray(0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previous);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (depthTest) {
+        glEnable(GL_DEPTH_TEST);
+    }
+}
+
+void LightVolume::bindTexture(int unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_3D, textures[front]);
+}
@@ -0,0 +1,75 @@
+#ifndef LIGHTVOLUME_H
+#define LIGHTVOLUME_H
+
+#include <cstdint>
+#include <memory>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Shader.h"
+
+// Transmittance towards the light over the SdfVolume box, rendered on the GPU one z
+// slice at a time into the layers of an R8 3D texture. The ray marcher reads it with a
+// single fetch instead of running the 16-step shadow march for every dense sample.
+// A re-bake is spread over several frames, kSlicesPerUpdate slices each, into a second
+// texture that replaces the shown one once its last slice is done.
+class LightVolume
+{
+public:
+    // How far the noise may rotate (iTime * 0.05 in cloud_common.glsl) before re-baking
+    static constexpr float kMaxAngleDrift = 0.005f;
+    static const int kSlicesPerUpdate = 16;
+
+    // Everything the baked transmittance depends on; any change triggers a re-bake
+    struct Inputs {
+        glm::vec3 lightDir = glm::vec3(0.0f);
+        std::uint64_t sceneHash = 0;    // SdfVolume::hash() of the current sphere set
+        bool useNoiseVolume = true;
+        bool useSdfVolume = true;
+        int shadowSteps = 0;            // uShadowSteps the transmittance is integrated with
+        float time = 0.0f;
+    };
+
+    // fullscreenTriangle is a VAO drawing one triangle that covers the viewport
+    LightVolume(int resolution, GLuint fullscreenTriangle);
+    ~LightVolume();
+    LightVolume(const LightVolume&) = delete;
+    LightVolume& operator=(const LightVolume&) = delete;
+
+    // Installs the bake program (light_volume_shader.glsl, already bound to the scene
+    // blocks and samplers) and forces a re-bake
+    void setProgram(std::unique_ptr<Shader> bakeProgram);
+
+    // Re-bakes if the inputs changed or the noise rotated by more than kMaxAngleDrift:
+    // bakes the next slices of the pending volume, or all of them when nothing was baked
+    // yet, and returns true when a finished volume is swapped in. A bake in progress keeps
+    // the inputs it started with. The current frame's uniform blocks and scene textures
+    // must be bound. Restores the framebuffer and viewport; the caller re-binds its own program.
+    bool update(const Inputs& inputs);
+
+    void bindTexture(int unit) const;
+    int resolution() const { return size; }
+
+private:
+    bool needsBake(const Inputs& inputs) const;
+    void bakeSlices(int first, int last);
+
+    std::unique_ptr<Shader> program;
+    UniformHandle sliceLoc;
+    UniformHandle sizeLoc;
+    UniformHandle useNoiseVolumeLoc;
+    UniformHandle useSdfVolumeLoc;
+
+    GLuint textures[2] = { 0, 0 };     // The shown volume and the one being baked
+    int front = 0;
+    GLuint framebuffer = 0;
+    GLuint triangle = 0;
+    int size = 0;
+
+    Inputs baked;                       // Inputs of the shown volume
+    Inputs pending;                     // Inputs of the bake in progress
+    bool baking = false;
+    int nextSlice = 0;                  // First slice of the pending bake still to render
+    bool dirty = true;
+};
+
+#endif // LIGHTVOLUME_H
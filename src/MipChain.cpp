@@ -0,0 +1,159 @@
+#include "MipChain.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace {
+    // Taps of one axis pass: output texel i reads input texels 2i + first .. 2i + first + taps - 1
+    struct Kernel
+    {
+        int first;
+        int taps;
+        float weights[6];
+    };
+
+    // Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    Kernel makeKernel(MipFilter filter)
+    {
+        if (filter == MipFilter::Box)
+            return { 0, 2, { 0.5f, 0.5f } };
+
+        // Half-band sinc under a Kaiser window three input texels wide. The output texel
+        // center falls between input texels 2i and 2i + 1, so the taps sit at +-0.5, +-1.5, +-2.5.
+        const double kRadius = 3.0, kAlpha = 4.0, kPi = 3.14159265358979323846;
+        Kernel kernel = { -2, 6, {} };
+        double weights[6], total = 0.0;
+        for (int t = 0; t < 6; t++)
+        {
+            double x = t - 2.5;
+            double sinc = std::sin(kPi * x * 0.5) / (kPi * x * 0.5);
+            double window = besselI0(kAlpha * std::sqrt(1.0 - (x / kRadius) * (x / kRadius))) / besselI0(kAlpha);
+            weights[t] = sinc * window;
+            total += weights[t];
+        }
+        for (int t = 0; t < 6; t++)
+            kernel.weights[t] = (float)(weights[t] / total);
+        return kernel;
+    }
+
+    int wrap(int i, int size)
+    {
+        int r = i % size;
+        return r < 0 ? r + size : r;
+    }
+
+    // Halves axis `axis` of a size[0] x size[1] x size[2] image of interleaved channels
+    void halveAxis(const float* src, const int size[3], int channels, int axis, const Kernel& kernel, float* dst)
+    {
+        int out[3] = { size[0], size[1], size[2] };
+        out[axis] = size[axis] / 2;
+        const size_t stride[3] = { (size_t)channels, (size_t)size[0] * channels, (size_t)size[0] * size[1] * channels };
+        ThreadPool::shared().parallelFor(out[1] * out[2], 4, [&](int rowBegin, int rowEnd) {
+            for (int row = rowBegin; row < rowEnd; row++)
+            {
+                int c[3] = { 0, row % out[1], row / out[1] };
+                float* target = dst + (size_t)row * out[0] * channels;
+                for (c[0] = 0; c[0] < out[0]; c[0]++, target += channels)
+                {
+                    size_t base = 0;
+                    for (int k = 0; k < 3; k++)
+                        if (k != axis)
+                            base += (size_t)c[k] * stride[k];
+                    for (int ch = 0; ch < channels; ch++)
+                        target[ch] = 0.0f;
+                    for (int t = 0; t < kernel.taps; t++)
+                    {
+                        const float* texel = src + base + (size_t)wrap(2 * c[axis] + kernel.first + t, size[axis]) * stride[axis];
+                        for (int ch = 0; ch < channels; ch++)
+                            target[ch] += kernel.weights[t] * texel[ch];
+                    }
+                }
+            }
+        });
+    }
+}
+
+bool MipChain::build(const void* level0, int width, int height, int depth, int channels, int bytesPerChannel,
+                     MipFilter filter)
+{
+    levels.clear();
+    if (!level0 || width < 1 || height < 1 || depth < 1 || channels < 1 || channels > 4 ||
+        (bytesPerChannel != 1 && bytesPerChannel != 2))
+        return false;
+
+    // Level sizes first, so the texels are sized once
+    size_t total = 0;
+    for (int w = width, h = height, d = depth; w > 1 || h > 1 || d > 1;)
+    {
+        w = std::max(w / 2, 1);
+        h = std::max(h / 2, 1);
+        d = std::max(d / 2, 1);
+        size_t bytes = (size_t)w * h * d * channels * bytesPerChannel;
+        levels.push_back({ w, h, d, total, bytes });
+        total += bytes;
+    }
+    texels.resize(total);
+
+    const float maxValue = bytesPerChannel == 1 ? 255.0f : 65535.0f;
+    size_t count = (size_t)width * height * depth * channels;
+    current.resize(count);
+    if (bytesPerChannel == 1)
+    {
+        const unsigned char* in = static_cast<const unsigned char*>(level0);
+        for (size_t i = 0; i < count; i++)
+            current[i] = in[i] / maxValue;
+    }
+    else
+    {
+        const std::uint16_t* in = static_cast<const std::uint16_t*>(level0);
+        for (size_t i = 0; i < count; i++)
+            current[i] = in[i] / maxValue;
+    }
+
+    const Kernel kernel = makeKernel(filter);
+    int size[3] = { width, height, depth };
+    for (const Level& level : levels)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (size[axis] == 1)
+                continue;
+            scratch.resize(count / size[axis] * (size[axis] / 2));
+            halveAxis(current.data(), size, channels, axis, kernel, scratch.data());
+            std::swap(current, scratch);
+            count = count / size[axis] * (size[axis] / 2);
+            size[axis] /= 2;
+        }
+
+        // Round to the nearest unorm step; the Kaiser lobes can overshoot [0, 1]
+        unsigned char* out = texels.data() + level.offset;
+        for (size_t i = 0; i < count; i++)
+        {
+            float v = std::min(std::max(current[i], 0.0f), 1.0f) * maxValue + 0.5f;
+            if (bytesPerChannel == 1)
+            {
+                out[i] = (unsigned char)v;
+            }
+            else
+            {
+                std::uint16_t value = (std::uint16_t)v;
+                std::memcpy(out + i * 2, &value, sizeof(value));
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef MIPCHAIN_H
+#define MIPCHAIN_H
+
+#include <cstddef>
+#include <vector>
+
+// Downsampling filter of MipChain
+enum class MipFilter {
+    Box,        // 2-texel average per axis, what glGenerateMipmap does for even sizes
+    Kaiser      // Kaiser-windowed sinc over 6 texels per axis; sharper levels, less blur
+};
+
+// Mip levels of a tileable unorm image (2D, or 3D when depth > 1) built on the CPU, so the
+// texture can be uploaded complete instead of stalling on glGenerateMipmap at load. Each
+// level halves every axis longer than one texel (rounding down, like GL) with a separable
+// filter that wraps around the edges, matching GL_REPEAT. Filtering runs in float on
+// ThreadPool::shared(), one output row per task. Level 0 is not copied: the chain holds
+// levels 1 and up, and its buffers are reused by the next build.
+class MipChain
+{
+public:
+    struct Level {
+        int width;
+        int height;
+        int depth;
+        size_t offset;      // Into the chain's texels
+        size_t bytes;
+    };
+
+    // `channels` interleaved channels of `bytesPerChannel` (1 or 2) bytes per texel.
+    // Returns false and leaves the chain empty on an unsupported layout.
+    bool build(const void* level0, int width, int height, int depth, int channels, int bytesPerChannel,
+               MipFilter filter = MipFilter::Box);
+
+    // Levels including level 0; 1 when nothing was built
+    int levelCount() const { return (int)levels.size() + 1; }
+    // Level 1 and up
+    const Level& level(int index) const { return levels[index - 1]; }
+    const unsigned char* data(int index) const { return texels.data() + level(index).offset; }
+
+private:
+    std::vector<Level> levels;
+    std::vector<unsigned char> texels;  // Levels 1 and up, back to back
+    std::vector<float> current;         // Float copy of the level being filtered
+    std::vector<float> scratch;         // Between the axis passes of one level
+};
+
+#endif // MIPCHAIN_H
@@ -1,14 +1,14 @@
 #include "Noise.h"
+#include "Random.h"
+#include "Simd.h"
+#include "ThreadPool.h"
 #include <cmath>
-#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <algorithm>
 
 // Anonymous namespace to encapsulate the Perlin noise implementation details
 namespace {
-    // Global permutation array of size 512 used for Perlin noise calculations
-    int p[512];
-
     // Smooth interpolation function (defined by Ken Perlin)
     double fade(double t) {
         return t * t * t * (t * (t * 6 - 15) + 10);
@@ -27,59 +27,297 @@ namespace {
         return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
     }
 
-    // Initialize the permutation array `p[]` using a given seed
-    void initPermutation(int seed) {
-        std::vector<int> permutation(256);
-        for (int i = 0; i < 256; i++) {
-            permutation[i] = i;
+    // Gradient for 3D improved noise: dot product with one of 12 cube-edge directions
+    double grad(int hash, double x, double y, double z) {
+        int h = hash & 15;
+        double u = h < 8 ? x : y;
+        double v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+        return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+    }
+
+    // Integer lattice hash used to place Worley feature points
+    std::uint32_t hashCell(int x, int y, int z, std::uint32_t seed) {
+        std::uint32_t h = seed ^ ((std::uint32_t)x * 0x8da6b343u) ^ ((std::uint32_t)y * 0xd8163841u)
+                               ^ ((std::uint32_t)z * 0xcb1ab31fu);
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        h *= 0x846ca68bu;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // Integer modulo that stays positive for negative lattice coordinates
+    int wrapCell(int i, int period) {
+        int r = i % period;
+        return r < 0 ? r + period : r;
+    }
+
+    // Tileable Worley (cellular) noise: one feature point per cell, returns 1 - F1 in [0, 1]
+    double worley(double x, double y, double z, int period, std::uint32_t seed) {
+        int cx = (int)floor(x), cy = (int)floor(y), cz = (int)floor(z);
+        double best = 1e9;
+        for (int dz = -1; dz <= 1; dz++)
+        for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++) {
+            int ix = cx + dx, iy = cy + dy, iz = cz + dz;
+            std::uint32_t h = hashCell(wrapCell(ix, period), wrapCell(iy, period), wrapCell(iz, period), seed);
+            // Three 10-bit offsets of the feature point inside its cell
+            double fx = ix + (double)(h & 1023u) / 1024.0;
+            double fy = iy + (double)((h >> 10) & 1023u) / 1024.0;
+            double fz = iz + (double)((h >> 20) & 1023u) / 1024.0;
+            double d = (x - fx) * (x - fx) + (y - fy) * (y - fy) + (z - fz) * (z - fz);
+            best = std::min(best, d);
         }
-        // Shuffle using the given seed
-        srand(seed);
-        for (int i = 255; i > 0; i--) {
-            int j = rand() % (i + 1);
-            std::swap(permutation[i], permutation[j]);
+        return std::max(0.0, 1.0 - std::sqrt(best));
+    }
+
+    // Tileable fBm of Perlin noise mapped to [0, 1]
+    double perlinFbm(const PerlinNoise& perlin, double x, double y, double z, int frequency, int octaves, double gain) {
+        double sum = 0.0, amplitude = 1.0, norm = 0.0;
+        for (int o = 0; o < octaves; o++) {
+            int f = frequency << o;
+            sum += amplitude * perlin.noise(x * f, y * f, z * f, f);
+            norm += amplitude;
+            amplitude *= gain;
         }
-        // Duplicate the permutation values to extend it to 512 elements
-        for (int i = 0; i < 256; i++) {
-            p[i] = permutation[i];
-            p[i + 256] = permutation[i];
+        return std::min(std::max((sum / norm + 1.0) * 0.5, 0.0), 1.0);
+    }
+
+    // Tileable fBm of Worley noise in [0, 1]
+    double worleyFbm(double x, double y, double z, int frequency, int octaves, double gain, std::uint32_t seed) {
+        double sum = 0.0, amplitude = 1.0, norm = 0.0;
+        for (int o = 0; o < octaves; o++) {
+            int f = frequency << o;
+            sum += amplitude * worley(x * f, y * f, z * f, f, seed + (std::uint32_t)o);
+            norm += amplitude;
+            amplitude *= gain;
         }
+        return sum / norm;
+    }
+
+    // Rescales v from [lo0, hi0] to [lo1, hi1]
+    double remap(double v, double lo0, double hi0, double lo1, double hi1) {
+        return lo1 + (v - lo0) / (hi0 - lo0) * (hi1 - lo1);
+    }
+
+    // Rows handed to a worker at a time
+    const int kRowGrain = 16;
+
+    // Gradient of grad() expressed as per-hash coefficients: grad(h, x, y) == kGradX[h]*x + kGradY[h]*y
+    const float kGradX[8] = { 1.f, -1.f,  1.f, -1.f, 1.f,  1.f, -1.f, -1.f };
+    const float kGradY[8] = { 1.f,  1.f, -1.f, -1.f, 1.f, -1.f,  1.f, -1.f };
+
+    // Converts a noise value in [-1, 1] to a byte exactly like the reference loop
+    unsigned char toByte(double noiseValue) {
+        noiseValue = (noiseValue + 1.0) / 2.0;
+        noiseValue = std::min(std::max(noiseValue, 0.0), 1.0);
+        return (unsigned char)(noiseValue * 255);
     }
 
-    // 2D Perlin noise function, returns a value approximately in the range [-1, 1]
-    double perlin(double x, double y) {
-        // Determine grid cell coordinates
-        int X = (int)floor(x) & 255;
-        int Y = (int)floor(y) & 255;
-        // Compute fractional part of input coordinates
-        x -= floor(x);
-        y -= floor(y);
-        // Compute fade curves for x and y
-        double u = fade(x);
-        double v = fade(y);
-        // Hash coordinates of the four cell corners
-        int A = p[X] + Y;
-        int B = p[X + 1] + Y;
-        // Perform bilinear interpolation using gradient values
-        double res = lerp(v,
-                          lerp(u, grad(p[A], x, y),
-                                  grad(p[B], x - 1, y)),
-                          lerp(u, grad(p[A + 1], x, y - 1),
-                                  grad(p[B + 1], x - 1, y - 1)));
-        return res;
+    // One texture row in double precision. Performs the same floating-point operations
+    // as PerlinNoise::noise() in the same order, with the row-constant y terms computed once.
+    void perlinRowDeterministic(const std::uint8_t* p, int j, int width, int height, double frequency, unsigned char* out) {
+        double y = (double)j / (double)height * frequency;
+        double fy = floor(y);
+        int Y = (int)fy & 255;
+        double yf = y - fy;
+        double v = fade(yf);
+        for (int i = 0; i < width; i++) {
+            double x = (double)i / (double)width * frequency;
+            double fx = floor(x);
+            int X = (int)fx & 255;
+            double xf = x - fx;
+            double u = fade(xf);
+            int A = p[X] + Y;
+            int B = p[X + 1] + Y;
+            double res = lerp(v,
+                              lerp(u, grad(p[A], xf, yf),
+                                      grad(p[B], xf - 1, yf)),
+                              lerp(u, grad(p[A + 1], xf, yf - 1),
+                                      grad(p[B + 1], xf - 1, yf - 1)));
+            out[i] = toByte(res);
+        }
+    }
+
+    // One row of an R16 or RGBA8Octaves texture, from the same noise() calls as the scalar loop
+    void perlinRowWide(const PerlinNoise& perlin, Noise::Format format, int j, int width, int height,
+                       unsigned char* out) {
+        double y = (double)j / (double)height;
+        for (int i = 0; i < width; i++) {
+            double x = (double)i / (double)width;
+            if (format == Noise::Format::R16) {
+                double value = (perlin.noise(x * Noise::kTextureFrequency, y * Noise::kTextureFrequency) + 1.0) / 2.0;
+                std::uint16_t texel = (std::uint16_t)(std::min(std::max(value, 0.0), 1.0) * 65535.0 + 0.5);
+                std::memcpy(out + (size_t)i * 2, &texel, sizeof(texel));
+            } else {
+                for (int octave = 0; octave < 4; octave++) {
+                    double frequency = Noise::kTextureFrequency * (1 << octave);
+                    out[(size_t)i * 4 + octave] = toByte(perlin.noise(x * frequency, y * frequency));
+                }
+            }
+        }
+    }
+
+    // One texture row in single precision, simd::kLanes pixels at a time. Hashing is
+    // done per lane; fade, gradients and interpolation run on the vector unit.
+    void perlinRowFast(const std::uint8_t* p, int j, int width, int height, float frequency, unsigned char* out) {
+        using simd::f32x8;
+        const int W = simd::kLanes;
+        float y = (float)j / (float)height * frequency;
+        float fy = std::floor(y);
+        int Y = (int)fy & 255;
+        float yf = y - fy;
+        float v = yf * yf * yf * (yf * (yf * 6.f - 15.f) + 10.f);
+        float xScale = frequency / (float)width;
+
+        const f32x8 one = f32x8::set1(1.f);
+        const f32x8 vYf = f32x8::set1(yf);
+        const f32x8 vYf1 = f32x8::set1(yf - 1.f);
+        const f32x8 vV = f32x8::set1(v);
+
+        alignas(32) float xf[W], gx00[W], gy00[W], gx10[W], gy10[W], gx01[W], gy01[W], gx11[W], gy11[W], res[W];
+        for (int i0 = 0; i0 < width; i0 += W) {
+            int lanes = std::min(W, width - i0);
+            for (int l = 0; l < W; l++) {
+                // Padding lanes past the end of the row replicate the last pixel
+                float x = (float)(i0 + std::min(l, lanes - 1)) * xScale;
+                float fx = std::floor(x);
+                int X = (int)fx & 255;
+                xf[l] = x - fx;
+                int A = p[X] + Y;
+                int B = p[X + 1] + Y;
+                int h00 = p[A] & 7, h10 = p[B] & 7, h01 = p[A + 1] & 7, h11 = p[B + 1] & 7;
+                gx00[l] = kGradX[h00]; gy00[l] = kGradY[h00];
+                gx10[l] = kGradX[h10]; gy10[l] = kGradY[h10];
+                gx01[l] = kGradX[h01]; gy01[l] = kGradY[h01];
+                gx11[l] = kGradX[h11]; gy11[l] = kGradY[h11];
+            }
+
+            f32x8 x0 = f32x8::load(xf);
+            f32x8 x1 = x0 - one;
+            f32x8 n00 = f32x8::load(gx00) * x0 + f32x8::load(gy00) * vYf;
+            f32x8 n10 = f32x8::load(gx10) * x1 + f32x8::load(gy10) * vYf;
+            f32x8 n01 = f32x8::load(gx01) * x0 + f32x8::load(gy01) * vYf1;
+            f32x8 n11 = f32x8::load(gx11) * x1 + f32x8::load(gy11) * vYf1;
+            f32x8 u = x0 * x0 * x0 * (x0 * (x0 * f32x8::set1(6.f) - f32x8::set1(15.f)) + f32x8::set1(10.f));
+            f32x8 nx0 = n00 + u * (n10 - n00);
+            f32x8 nx1 = n01 + u * (n11 - n01);
+            f32x8 n = nx0 + vV * (nx1 - nx0);
+            // Map [-1, 1] to [0, 255] with the same clamp as the reference loop
+            n = simd::min(simd::max((n + one) * f32x8::set1(0.5f), f32x8::set1(0.f)), one) * f32x8::set1(255.f);
+            n.store(res);
+            for (int l = 0; l < lanes; l++) {
+                out[i0 + l] = (unsigned char)res[l];
+            }
+        }
+    }
+}
+
+// Builds the permutation table for a seed: a Fisher-Yates shuffle of 0..255 driven by
+// xoshiro256**, duplicated to 512 entries so corner hashes never need wrapping
+PerlinNoise::PerlinNoise(int seed) : seedValue(seed) {
+    std::uint8_t permutation[256];
+    for (int i = 0; i < 256; i++) {
+        permutation[i] = (std::uint8_t)i;
+    }
+    Xoshiro256 rng((std::uint64_t)(std::uint32_t)seed);
+    for (int i = 255; i > 0; i--) {
+        int j = (int)rng.below((std::uint32_t)(i + 1));
+        std::swap(permutation[i], permutation[j]);
     }
+    for (int i = 0; i < 256; i++) {
+        perm[i] = permutation[i];
+        perm[i + 256] = permutation[i];
+    }
+}
+
+// 2D Perlin noise function, returns a value approximately in the range [-1, 1]
+double PerlinNoise::noise(double x, double y) const {
+    const std::uint8_t* p = perm;
+    // Determine grid cell coordinates
+    int X = (int)floor(x) & 255;
+    int Y = (int)floor(y) & 255;
+    // Compute fractional part of input coordinates
+    x -= floor(x);
+    y -= floor(y);
+    // Compute fade curves for x and y
+    double u = fade(x);
+    double v = fade(y);
+    // Hash coordinates of the four cell corners
+    int A = p[X] + Y;
+    int B = p[X + 1] + Y;
+    // Perform bilinear interpolation using gradient values
+    double res = lerp(v,
+                      lerp(u, grad(p[A], x, y),
+                              grad(p[B], x - 1, y)),
+                      lerp(u, grad(p[A + 1], x, y - 1),
+                              grad(p[B + 1], x - 1, y - 1)));
+    return res;
+}
+
+// 3D improved Perlin noise on a lattice that repeats every `period` cells
+double PerlinNoise::noise(double x, double y, double z, int period) const {
+    const std::uint8_t* p = perm;
+    double fx = floor(x), fy = floor(y), fz = floor(z);
+    // Wrap lattice coordinates so the noise tiles with the requested period
+    int X0 = wrapCell((int)fx, period) & 255, X1 = wrapCell((int)fx + 1, period) & 255;
+    int Y0 = wrapCell((int)fy, period) & 255, Y1 = wrapCell((int)fy + 1, period) & 255;
+    int Z0 = wrapCell((int)fz, period) & 255, Z1 = wrapCell((int)fz + 1, period) & 255;
+    x -= fx;
+    y -= fy;
+    z -= fz;
+    double u = fade(x), v = fade(y), w = fade(z);
+    // Hash the eight cell corners
+    int A0 = p[p[X0] + Y0], A1 = p[p[X0] + Y1];
+    int B0 = p[p[X1] + Y0], B1 = p[p[X1] + Y1];
+    double res = lerp(w,
+                      lerp(v, lerp(u, grad(p[A0 + Z0], x, y, z),     grad(p[B0 + Z0], x - 1, y, z)),
+                              lerp(u, grad(p[A1 + Z0], x, y - 1, z), grad(p[B1 + Z0], x - 1, y - 1, z))),
+                      lerp(v, lerp(u, grad(p[A0 + Z1], x, y, z - 1),     grad(p[B0 + Z1], x - 1, y, z - 1)),
+                              lerp(u, grad(p[A1 + Z1], x, y - 1, z - 1), grad(p[B1 + Z1], x - 1, y - 1, z - 1))));
+    return res;
 }
 
 // Generates a Perlin noise texture of specified width and height using a seed
-std::vector<unsigned char> Noise::generatePerlinNoiseTexture(int width, int height, int seed) {
-    // Initialize the permutation table with the given seed
-    initPermutation(seed);
+std::vector<unsigned char> Noise::generatePerlinNoiseTexture(int width, int height, int seed, Mode mode) {
+    return generatePerlinNoiseTexture(PerlinNoise(seed), width, height, mode);
+}
 
+// Generates a Perlin noise texture from an existing noise object
+std::vector<unsigned char> Noise::generatePerlinNoiseTexture(const PerlinNoise& perlin, int width, int height, Mode mode) {
     // Vector to store the grayscale noise texture data (size: width * height)
-    std::vector<unsigned char> textureData(width * height);
+    std::vector<unsigned char> textureData((size_t)width * height);
+    generatePerlinNoiseTexture(perlin, width, height, Span<unsigned char>(textureData), mode);
+    return textureData;
+}
+
+// Fills a caller-provided texture buffer; safe to call concurrently, since the only
+// shared state is the read-only permutation table
+bool Noise::generatePerlinNoiseTexture(const PerlinNoise& perlin, int width, int height, Span<unsigned char> out,
+                                       Mode mode) {
+    if (out.size() < (size_t)width * height) {
+        return false;
+    }
+    const std::uint8_t* p = perlin.permutation();
+    unsigned char* textureData = out.data();
 
     // Controls the level of detail in the noise (higher values create finer noise patterns)
-    double frequency = 8.0;
+    double frequency = kTextureFrequency;
+
+    // Parallel paths: every row is independent and only reads the permutation table
+    if (mode != Mode::Scalar) {
+        ThreadPool::shared().parallelFor(height, kRowGrain, [&](int rowBegin, int rowEnd) {
+            for (int j = rowBegin; j < rowEnd; j++) {
+                if (mode == Mode::Deterministic) {
+                    perlinRowDeterministic(p, j, width, height, frequency, textureData + (size_t)j * width);
+                } else {
+                    perlinRowFast(p, j, width, height, (float)frequency, textureData + (size_t)j * width);
+                }
+            }
+        });
+        return true;
+    }
 
     for (int j = 0; j < height; j++) {
         for (int i = 0; i < width; i++) {
@@ -87,7 +325,7 @@ std::vector<unsigned char> Noise::generatePerlinNoiseTexture(int width, int heig
             double x = (double)i / (double)width;
             double y = (double)j / (double)height;
             // Compute Perlin noise value at (x, y)
-            double noiseValue = perlin(x * frequency, y * frequency);
+            double noiseValue = perlin.noise(x * frequency, y * frequency);
             // Map Perlin noise value from [-1, 1] to [0, 1]
             noiseValue = (noiseValue + 1.0) / 2.0;
             // Clamp values to ensure they remain in the [0,1] range
@@ -97,5 +335,91 @@ std::vector<unsigned char> Noise::generatePerlinNoiseTexture(int width, int heig
             textureData[j * width + i] = value;
         }
     }
+    return true;
+}
+
+int Noise::bytesPerTexel(Format format) {
+    return format == Format::R16 ? 2 : format == Format::RGBA8Octaves ? 4 : 1;
+}
+
+std::vector<unsigned char> Noise::generatePerlinNoiseTexture(int width, int height, int seed, Format format, Mode mode) {
+    std::vector<unsigned char> textureData((size_t)width * height * bytesPerTexel(format));
+    generatePerlinNoiseTexture(PerlinNoise(seed), width, height, format, Span<unsigned char>(textureData), mode);
     return textureData;
 }
+
+bool Noise::generatePerlinNoiseTexture(const PerlinNoise& perlin, int width, int height, Format format,
+                                       Span<unsigned char> out, Mode mode) {
+    if (format == Format::R8) {
+        return generatePerlinNoiseTexture(perlin, width, height, out, mode);
+    }
+    size_t rowBytes = (size_t)width * bytesPerTexel(format);
+    if (out.size() < rowBytes * height) {
+        return false;
+    }
+    unsigned char* textureData = out.data();
+    if (mode == Mode::Scalar) {
+        for (int j = 0; j < height; j++) {
+            perlinRowWide(perlin, format, j, width, height, textureData + (size_t)j * rowBytes);
+        }
+        return true;
+    }
+    ThreadPool::shared().parallelFor(height, kRowGrain, [&](int rowBegin, int rowEnd) {
+        for (int j = rowBegin; j < rowEnd; j++) {
+            perlinRowWide(perlin, format, j, width, height, textureData + (size_t)j * rowBytes);
+        }
+    });
+    return true;
+}
+
+std::uint32_t Noise::worleySeed(int seed) {
+    return hashCell(seed, 0x5eed, 0x3d, 0x9e3779b9u);
+}
+
+// Generates the tileable Perlin-Worley RGBA volume used for volumetric cloud detail
+std::vector<unsigned char> Noise::generatePerlinWorleyVolume(int size, int seed, const NoiseVolumeParams& params) {
+    std::vector<unsigned char> volume((size_t)size * size * size * 4);
+    generatePerlinWorleyVolume(size, seed, params, Span<unsigned char>(volume));
+    return volume;
+}
+
+bool Noise::generatePerlinWorleyVolume(int size, int seed, const NoiseVolumeParams& params, Span<unsigned char> volume) {
+    if (volume.size() < (size_t)size * size * size * 4) {
+        return false;
+    }
+    PerlinNoise perlin(seed);
+    std::uint32_t worleySeed = Noise::worleySeed(seed);
+    const int base = params.baseFrequency;
+    const int octaves = params.octaves;
+    const double gain = params.gain;
+
+    auto quantize = [](double v) {
+        return (unsigned char)(std::min(std::max(v, 0.0), 1.0) * 255.0 + 0.5);
+    };
+
+    // Each z slice is independent; hand one slice to a worker at a time
+    ThreadPool::shared().parallelFor(size, 1, [&](int zBegin, int zEnd) {
+        for (int k = zBegin; k < zEnd; k++) {
+            for (int j = 0; j < size; j++) {
+                unsigned char* out = volume.data() + ((size_t)k * size + j) * size * 4;
+                for (int i = 0; i < size; i++) {
+                    // Sample at texel centers in [0, 1)
+                    double x = (i + 0.5) / size;
+                    double y = (j + 0.5) / size;
+                    double z = (k + 0.5) / size;
+
+                    // Perlin-Worley: Perlin fBm eroded by inverted Worley fBm at the same frequency
+                    double pf = perlinFbm(perlin, x, y, z, base, octaves, gain);
+                    double wf = worleyFbm(x, y, z, base, octaves, gain, worleySeed);
+                    double perlinWorley = remap(pf, wf - 1.0, 1.0, 0.0, 1.0);
+
+                    out[i * 4 + 0] = quantize(perlinWorley);
+                    out[i * 4 + 1] = quantize(worleyFbm(x, y, z, base * 2, octaves, gain, worleySeed + 101));
+                    out[i * 4 + 2] = quantize(worleyFbm(x, y, z, base * 4, octaves, gain, worleySeed + 202));
+                    out[i * 4 + 3] = quantize(worleyFbm(x, y, z, base * 8, octaves, gain, worleySeed + 303));
+                }
+            }
+        }
+    });
+    return true;
+}
@@ -1,12 +1,82 @@
 #ifndef NOISE_H
 #define NOISE_H
 
+#include <cstdint>
 #include <vector>
+#include "Span.h"
 
+// Seed-scoped 2D Perlin noise. Each instance owns its permutation table, so
+// different seeds can be built and evaluated on different threads at once.
+class PerlinNoise {
+public:
+    explicit PerlinNoise(int seed = 0);
+
+    // Returns a value approximately in the range [-1, 1]
+    double noise(double x, double y) const;
+    // 3D improved Perlin noise whose lattice wraps every `period` cells on each axis (period <= 256)
+    double noise(double x, double y, double z, int period) const;
+
+    int seed() const { return seedValue; }
+    // 512-entry table: the 256-entry permutation repeated twice
+    const std::uint8_t* permutation() const { return perm; }
+
+private:
+    alignas(64) std::uint8_t perm[512];
+    int seedValue;
+};
+
+// Parameters of the tileable Perlin-Worley volume. Frequencies are cells per tile,
+// so every channel wraps seamlessly at the volume boundary.
+struct NoiseVolumeParams {
+    int baseFrequency = 4;   // Cells across the tile for the base shape channel (R)
+    int octaves = 3;         // fBm octaves summed per channel
+    float gain = 0.5f;       // Amplitude falloff between octaves
+};
 
 class Noise {
 public:
-    static std::vector<unsigned char> generatePerlinNoiseTexture(int width, int height, int seed = 0);
+    // Evaluation strategy for the texture generators
+    enum class Mode {
+        Scalar,        // Single-threaded double-precision reference loop
+        Deterministic, // Rows split across the thread pool, bit-identical to Scalar
+        Fast           // Rows split across the thread pool, 8-lane float SIMD (may differ from Scalar by one step)
+    };
+
+    // Texel layout of the 2D noise texture
+    enum class Format {
+        R8,            // One byte per texel (the default)
+        R16,           // One 16-bit unorm channel: the same noise without 8-bit banding
+        RGBA8Octaves   // R, G, B, A = the noise at 1x, 2x, 4x and 8x the frequency; R matches R8
+    };
+
+    // Lattice cells across the 2D texture
+    static constexpr double kTextureFrequency = 8.0;
+
+    static int bytesPerTexel(Format format);
+
+    static std::vector<unsigned char> generatePerlinNoiseTexture(int width, int height, int seed = 0,
+                                                                 Mode mode = Mode::Deterministic);
+    static std::vector<unsigned char> generatePerlinNoiseTexture(const PerlinNoise& perlin, int width, int height,
+                                                                 Mode mode = Mode::Deterministic);
+    // Writes the texture into a caller-provided buffer of at least width * height bytes,
+    // so regenerating reuses it; returns false (writing nothing) if it is too small
+    static bool generatePerlinNoiseTexture(const PerlinNoise& perlin, int width, int height, Span<unsigned char> out,
+                                           Mode mode = Mode::Deterministic);
+    // Same in any Format, into at least width * height * bytesPerTexel(format) bytes (R16 in host
+    // byte order). R16 and RGBA8Octaves evaluate in double precision; Fast counts as Deterministic.
+    static bool generatePerlinNoiseTexture(const PerlinNoise& perlin, int width, int height, Format format,
+                                           Span<unsigned char> out, Mode mode = Mode::Deterministic);
+    static std::vector<unsigned char> generatePerlinNoiseTexture(int width, int height, int seed, Format format,
+                                                                 Mode mode = Mode::Deterministic);
+
+    // Tileable size^3 RGBA8 volume: R = Perlin-Worley fBm at the base frequency,
+    // G/B/A = Worley fBm at 2x, 4x and 8x the base frequency. Slices are built in parallel.
+    static std::vector<unsigned char> generatePerlinWorleyVolume(int size, int seed = 0,
+                                                                 const NoiseVolumeParams& params = NoiseVolumeParams());
+    // Same into a caller-provided buffer of at least size^3 * 4 bytes; false if it is too small
+    static bool generatePerlinWorleyVolume(int size, int seed, const NoiseVolumeParams& params, Span<unsigned char> out);
+    // Seed of the volume's Worley channels; the G/B/A channels add 101, 202 and 303 to it
+    static std::uint32_t worleySeed(int seed);
 };
 
 #endif // NOISE_H
@@ -0,0 +1,218 @@
+#include "NoiseCache.h"
+#include "CachePaths.h"
+#include "Hash.h"
+#include "Noise.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    // Bump whenever a generator's output changes for the same key, so stale files are regenerated
+    const std::uint32_t kAlgorithmVersion = 1;
+    const char kMagic[4] = { 'C', 'L', 'N', 'Z' };
+    const std::uint32_t kFormatVersion = 1;
+
+    // Fixed 64-byte file header; the payload starts right after it
+    struct FileHeader {
+        char magic[4];
+        std::uint32_t formatVersion;
+        std::uint32_t generator;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t depth;
+        std::uint32_t channels;
+        std::int32_t seed;
+        std::uint64_t paramsHash;
+        std::uint64_t payloadOffset;
+        std::uint64_t payloadSize;
+        std::uint64_t reserved;
+    };
+    static_assert(sizeof(FileHeader) == 64, "noise cache header must stay 64 bytes");
+
+    FileHeader makeHeader(const NoiseCacheKey& key) {
+        FileHeader h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.formatVersion = kFormatVersion;
+        h.generator = (std::uint32_t)key.generator;
+        h.width = key.width;
+        h.height = key.height;
+        h.depth = key.depth;
+        h.channels = key.channels;
+        h.seed = key.seed;
+        h.paramsHash = key.paramsHash;
+        h.payloadOffset = sizeof(FileHeader);
+        h.payloadSize = key.payloadSize();
+        return h;
+    }
+
+    bool headerMatches(const FileHeader& h, const NoiseCacheKey& key) {
+        FileHeader expected = makeHeader(key);
+        return std::memcmp(&h, &expected, sizeof(FileHeader)) == 0;
+    }
+}
+
+bool NoiseCacheKey::operator==(const NoiseCacheKey& o) const {
+    return generator == o.generator && width == o.width && height == o.height && depth == o.depth &&
+           channels == o.channels && seed == o.seed && paramsHash == o.paramsHash;
+}
+
+NoiseCacheKey NoiseCacheKey::perlin2D(int width, int height, int seed, Noise::Format format) {
+    NoiseCacheKey key;
+    key.generator = format == Noise::Format::R16 ? NoiseGenerator::Perlin2D16
+                  : format == Noise::Format::RGBA8Octaves ? NoiseGenerator::PerlinOctaves2D
+                  : NoiseGenerator::Perlin2D;
+    key.width = (std::uint32_t)width;
+    key.height = (std::uint32_t)height;
+    key.channels = (std::uint32_t)Noise::bytesPerTexel(format);
+    key.seed = seed;
+    key.paramsHash = fnv1a64(&kAlgorithmVersion, sizeof(kAlgorithmVersion));
+    return key;
+}
+
+NoiseCacheKey NoiseCacheKey::perlinWorley3D(int size, int seed, const NoiseVolumeParams& params) {
+    NoiseCacheKey key;
+    key.generator = NoiseGenerator::PerlinWorley3D;
+    key.width = key.height = key.depth = (std::uint32_t)size;
+    key.channels = 4;
+    key.seed = seed;
+    std::uint64_t h = fnv1a64(&kAlgorithmVersion, sizeof(kAlgorithmVersion));
+    h = fnv1a64(&params.baseFrequency, sizeof(params.baseFrequency), h);
+    h = fnv1a64(&params.octaves, sizeof(params.octaves), h);
+    h = fnv1a64(&params.gain, sizeof(params.gain), h);
+    key.paramsHash = h;
+    return key;
+}
+
+MappedNoiseTexture::~MappedNoiseTexture() {
+    release();
+}
+
+MappedNoiseTexture::MappedNoiseTexture(MappedNoiseTexture&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedNoiseTexture& MappedNoiseTexture::operator=(MappedNoiseTexture&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapping = other.mapping;
+        mappingBytes = other.mappingBytes;
+        payloadBytes = other.payloadBytes;
+        owned = std::move(other.owned);
+        payload = mapping ? other.payload : (owned.empty() ? nullptr : owned.data());
+        other.mapping = nullptr;
+        other.mappingBytes = 0;
+        other.payload = nullptr;
+        other.payloadBytes = 0;
+    }
+    return *this;
+}
+
+void MappedNoiseTexture::release() {
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+    }
+    mapping = nullptr;
+    mappingBytes = 0;
+    payload = nullptr;
+    payloadBytes = 0;
+    owned.clear();
+}
+
+NoiseCache::NoiseCache(std::string directory) : dir(std::move(directory)) {
+    if (dir.empty()) {
+        dir = cacheDirectory();
+    }
+}
+
+std::string NoiseCache::pathFor(const NoiseCacheKey& key) const {
+    char name[128];
+    std::snprintf(name, sizeof(name), "noise_%u_%ux%ux%u_c%u_s%d_%016llx.bin",
+                  (unsigned)key.generator, key.width, key.height, key.depth, key.channels, key.seed,
+                  (unsigned long long)key.paramsHash);
+    return (std::filesystem::path(dir) / name).string();
+}
+
+MappedNoiseTexture NoiseCache::load(const NoiseCacheKey& key) const {
+    MappedNoiseTexture result;
+    std::string path = pathFor(key);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return result;
+    }
+    struct stat st;
+    std::size_t expected = sizeof(FileHeader) + key.payloadSize();
+    if (fstat(fd, &st) != 0 || (std::size_t)st.st_size != expected) {
+        close(fd);
+        return result;
+    }
+    void* mem = mmap(nullptr, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (mem == MAP_FAILED) {
+        return result;
+    }
+    FileHeader header;
+    std::memcpy(&header, mem, sizeof(header));
+    if (!headerMatches(header, key)) {
+        munmap(mem, expected);
+        return result;
+    }
+    result.mapping = mem;
+    result.mappingBytes = expected;
+    result.payload = static_cast<const unsigned char*>(mem) + header.payloadOffset;
+    result.payloadBytes = header.payloadSize;
+    return result;
+}
+
+bool NoiseCache::store(const NoiseCacheKey& key, const unsigned char* data, std::size_t size) const {
+    if (size != key.payloadSize()) {
+        std::cerr << "Error::NoiseCache::Payload size does not match key" << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    std::string path = pathFor(key);
+    std::string tmpPath = path + ".tmp" + std::to_string((long long)getpid());
+    FILE* f = std::fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        std::cerr << "Error::NoiseCache::Could not write: " << tmpPath << std::endl;
+        return false;
+    }
+    FileHeader header = makeHeader(key);
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              std::fwrite(data, 1, size, f) == size;
+    ok = (std::fclose(f) == 0) && ok;
+    // Rename so concurrent readers never see a partially written file
+    if (!ok || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        std::cerr << "Error::NoiseCache::Could not write: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+MappedNoiseTexture NoiseCache::loadOrGenerate(const NoiseCacheKey& key,
+                                              const std::function<std::vector<unsigned char>()>& generate) const {
+    MappedNoiseTexture cached = load(key);
+    if (cached.valid()) {
+        return cached;
+    }
+    std::vector<unsigned char> data = generate();
+    if (store(key, data.data(), data.size())) {
+        cached = load(key);
+        if (cached.valid()) {
+            return cached;
+        }
+    }
+    // Cache not writable; hand out the freshly generated payload instead
+    cached.owned = std::move(data);
+    cached.payload = cached.owned.data();
+    cached.payloadBytes = cached.owned.size();
+    return cached;
+}
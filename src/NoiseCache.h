@@ -0,0 +1,84 @@
+#ifndef NOISECACHE_H
+#define NOISECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Noise.h"
+
+// Generators whose output can be cached
+enum class NoiseGenerator : std::uint32_t {
+    Perlin2D = 1,
+    PerlinWorley3D = 2,
+    Perlin2D16 = 3,         // Noise::Format::R16
+    PerlinOctaves2D = 4     // Noise::Format::RGBA8Octaves
+};
+
+// Identifies a cached noise texture; any field mismatch forces regeneration
+struct NoiseCacheKey {
+    NoiseGenerator generator = NoiseGenerator::Perlin2D;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint32_t depth = 1;
+    std::uint32_t channels = 1;    // Bytes per texel; a 16-bit channel counts as two
+    std::int32_t seed = 0;
+    std::uint64_t paramsHash = 0;  // Hash of generator parameters and algorithm version
+
+    bool operator==(const NoiseCacheKey& o) const;
+    std::size_t payloadSize() const { return (std::size_t)width * height * depth * channels; }
+
+    static NoiseCacheKey perlin2D(int width, int height, int seed, Noise::Format format = Noise::Format::R8);
+    static NoiseCacheKey perlinWorley3D(int size, int seed, const NoiseVolumeParams& params);
+};
+
+// Texel payload of a cache file mapped read-only into memory. When the cache
+// could not be written the payload is held in memory instead.
+class MappedNoiseTexture {
+public:
+    MappedNoiseTexture() = default;
+    ~MappedNoiseTexture();
+    MappedNoiseTexture(MappedNoiseTexture&& other) noexcept;
+    MappedNoiseTexture& operator=(MappedNoiseTexture&& other) noexcept;
+    MappedNoiseTexture(const MappedNoiseTexture&) = delete;
+    MappedNoiseTexture& operator=(const MappedNoiseTexture&) = delete;
+
+    bool valid() const { return payload != nullptr; }
+    bool isMapped() const { return mapping != nullptr; }
+    const unsigned char* data() const { return payload; }
+    std::size_t size() const { return payloadBytes; }
+
+private:
+    friend class NoiseCache;
+    void release();
+
+    void* mapping = nullptr;          // Whole-file mapping (header + payload)
+    std::size_t mappingBytes = 0;
+    const unsigned char* payload = nullptr;
+    std::size_t payloadBytes = 0;
+    std::vector<unsigned char> owned; // Fallback storage when nothing is mapped
+};
+
+// Binary on-disk cache of generated noise textures. Each file holds a fixed
+// header with the key followed by the raw texel payload.
+class NoiseCache {
+public:
+    // directory == "" uses $CLOUD_CACHE_DIR, or "cache" when unset
+    explicit NoiseCache(std::string directory = "");
+
+    // Maps the cached payload for `key`; returns an invalid texture on a miss or key mismatch
+    MappedNoiseTexture load(const NoiseCacheKey& key) const;
+    // Writes the payload atomically (temporary file + rename). Returns false on I/O failure.
+    bool store(const NoiseCacheKey& key, const unsigned char* data, std::size_t size) const;
+    // Loads the cached payload, or generates, stores and maps it on a miss
+    MappedNoiseTexture loadOrGenerate(const NoiseCacheKey& key,
+                                      const std::function<std::vector<unsigned char>()>& generate) const;
+
+    std::string pathFor(const NoiseCacheKey& key) const;
+
+private:
+    std::string dir;
+};
+
+#endif // NOISECACHE_H
@@ -0,0 +1,108 @@
+#include "PngWriter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Largest payload of one deflate stored block
+    const std::size_t kMaxStoredBlock = 65535;
+
+    std::uint32_t crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0)
+    {
+        static std::uint32_t table[256];
+        static bool initialized = false;
+        if (!initialized) {
+            for (std::uint32_t n = 0; n < 256; n++) {
+                std::uint32_t c = n;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            initialized = true;
+        }
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    std::uint32_t adler32(const unsigned char* data, std::size_t size)
+    {
+        std::uint32_t a = 1, b = 0;
+        for (std::size_t i = 0; i < size; i++) {
+            a = (a + data[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    void appendBigEndian(std::vector<unsigned char>& out, std::uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back((unsigned char)(value >> shift));
+        }
+    }
+
+    // Length, type, data and CRC of the type and data
+    void appendChunk(std::vector<unsigned char>& out, const char type[4], const std::vector<unsigned char>& data)
+    {
+        appendBigEndian(out, (std::uint32_t)data.size());
+        std::size_t typeStart = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        appendBigEndian(out, crc32(out.data() + typeStart, out.size() - typeStart));
+    }
+}
+
+bool writePng(const std::string& path, const unsigned char* rgb, int width, int height)
+{
+    // Every row starts with filter type 0 (none)
+    std::size_t rowBytes = (std::size_t)width * 3;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb + y * rowBytes, rgb + (y + 1) * rowBytes);
+    }
+
+    // zlib stream: header, stored blocks, Adler-32 of the uncompressed data
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    std::size_t offset = 0;
+    do {
+        std::size_t size = std::min(raw.size() - offset, kMaxStoredBlock);
+        bool last = offset + size == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((unsigned char)(size & 0xff));
+        zlib.push_back((unsigned char)(size >> 8));
+        zlib.push_back((unsigned char)(~size & 0xff));
+        zlib.push_back((unsigned char)((~size >> 8) & 0xff));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    } while (offset < raw.size());
+    appendBigEndian(zlib, adler32(raw.data(), raw.size()));
+
+    // 8-bit truecolor, no interlacing
+    std::vector<unsigned char> header;
+    appendBigEndian(header, (std::uint32_t)width);
+    appendBigEndian(header, (std::uint32_t)height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+    std::vector<unsigned char> file = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    appendChunk(file, "IHDR", header);
+    appendChunk(file, "IDAT", zlib);
+    appendChunk(file, "IEND", {});
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    bool ok = f && std::fwrite(file.data(), 1, file.size(), f) == file.size();
+    if (f && std::fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::cerr << "Error::PngWriter::Failed to write " << path << std::endl;
+    }
+    return ok;
+}
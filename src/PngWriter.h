@@ -0,0 +1,10 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <string>
+
+// Writes tightly packed RGB8 rows, top row first, as a PNG file. The image data is stored
+// uncompressed (deflate "stored" blocks), so no zlib is needed. Returns false on I/O failure.
+bool writePng(const std::string& path, const unsigned char* rgb, int width, int height);
+
+#endif // PNGWRITER_H
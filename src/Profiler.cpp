@@ -0,0 +1,240 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+Profiler::Profiler()
+    : epoch(Clock::now())
+{
+}
+
+Profiler::~Profiler()
+{
+    for (Pass& pass : passes) {
+        if (pass.queries[0]) {
+            glDeleteQueries(kQueryBuffers, pass.queries);
+        }
+    }
+}
+
+// Finds or registers a pass; there are only a handful, so a linear search is enough
+int Profiler::passIndex(const char* name)
+{
+    for (size_t i = 0; i < passes.size(); i++) {
+        if (passes[i].name == name) {
+            return (int)i;
+        }
+    }
+    passes.emplace_back();
+    passes.back().name = name;
+    return (int)passes.size() - 1;
+}
+
+const Profiler::Pass* Profiler::findPass(const std::string& name) const
+{
+    for (const Pass& pass : passes) {
+        if (pass.name == name) {
+            return &pass;
+        }
+    }
+    return nullptr;
+}
+
+double Profiler::microseconds(Clock::time_point t) const
+{
+    return std::chrono::duration<double, std::micro>(t - epoch).count();
+}
+
+void Profiler::pushSample(std::vector<float>& ring, int& next, float value)
+{
+    if ((int)ring.size() < kHistoryFrames) {
+        ring.push_back(value);
+    } else {
+        ring[next] = value;
+    }
+    next = (next + 1) % kHistoryFrames;
+}
+
+void Profiler::addTraceEvent(int pass, bool gpu, double startUs, double durationUs)
+{
+    // Long sessions keep their beginning rather than growing without bound
+    if (events.size() < kMaxTraceEvents) {
+        events.push_back({ pass, gpu, startUs, durationUs });
+    }
+}
+
+void Profiler::addCpuSample(int pass, Clock::time_point start, Clock::time_point end)
+{
+    double durationUs = std::chrono::duration<double, std::micro>(end - start).count();
+    pushSample(passes[pass].cpuMs, passes[pass].cpuNext, (float)(durationUs / 1000.0));
+    addTraceEvent(pass, false, microseconds(start), durationUs);
+}
+
+void Profiler::beginFrame()
+{
+    if (!active) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    if (frameStarted) {
+        addCpuSample(passIndex("frame"), frameStart, now);
+    }
+    frameStart = now;
+    frameStarted = true;
+
+    // This frame reuses the queries of kQueryBuffers frames ago; read what has arrived
+    slot = (slot + 1) % kQueryBuffers;
+    float frameMs = 0.0f;
+    bool complete = false;
+    for (Pass& pass : passes) {
+        if (!pass.issued[slot]) {
+            continue;
+        }
+        pass.issued[slot] = false;
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(pass.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            frameMs = -1.0f;
+            continue;
+        }
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(pass.queries[slot], GL_QUERY_RESULT, &elapsed);
+        double durationUs = (double)elapsed / 1000.0;
+        if (frameMs >= 0.0f) {
+            frameMs += (float)(durationUs / 1000.0);
+            complete = true;
+        }
+        pushSample(pass.gpuMs, pass.gpuNext, (float)(durationUs / 1000.0));
+        addTraceEvent((int)(&pass - passes.data()), true, pass.issuedAt[slot], durationUs);
+    }
+    gpuFrameMs = complete && frameMs >= 0.0f ? frameMs : -1.0f;
+}
+
+Profiler::CpuScope::CpuScope(Profiler& profiler, const char* name)
+    : owner(profiler), pass(profiler.active ? profiler.passIndex(name) : -1), start(Clock::now())
+{
+}
+
+Profiler::CpuScope::~CpuScope()
+{
+    if (pass >= 0) {
+        owner.addCpuSample(pass, start, Clock::now());
+    }
+}
+
+Profiler::GpuScope::GpuScope(Profiler& profiler, const char* name)
+    : owner(profiler), pass(profiler.active ? profiler.passIndex(name) : -1), start(Clock::now())
+{
+    if (pass < 0) {
+        return;
+    }
+    if (owner.gpuScopeOpen) {
+        if (!owner.warnedNesting) {
+            std::cerr << "Error::Profiler::GPU scope \"" << name << "\" is nested; only its CPU time is recorded"
+                      << std::endl;
+            owner.warnedNesting = true;
+        }
+        return;
+    }
+
+    Pass& p = owner.passes[pass];
+    if (!p.queries[0]) {
+        glGenQueries(kQueryBuffers, p.queries);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, p.queries[owner.slot]);
+    p.issuedAt[owner.slot] = owner.microseconds(start);
+    owner.gpuScopeOpen = true;
+    query = true;
+}
+
+Profiler::GpuScope::~GpuScope()
+{
+    if (pass < 0) {
+        return;
+    }
+    if (query) {
+        glEndQuery(GL_TIME_ELAPSED);
+        owner.passes[pass].issued[owner.slot] = true;
+        owner.gpuScopeOpen = false;
+    }
+    owner.addCpuSample(pass, start, Clock::now());
+}
+
+// Nearest-rank percentiles over a copy of the ring
+Profiler::Percentiles Profiler::percentiles(const std::vector<float>& ring)
+{
+    Percentiles result;
+    result.samples = (int)ring.size();
+    if (ring.empty()) {
+        return result;
+    }
+    std::vector<float> sorted(ring);
+    std::sort(sorted.begin(), sorted.end());
+    auto rank = [&](float q) { return sorted[std::min(sorted.size() - 1, (size_t)(q * (float)sorted.size()))]; };
+    result.p50 = rank(0.50f);
+    result.p95 = rank(0.95f);
+    result.p99 = rank(0.99f);
+    return result;
+}
+
+Profiler::Percentiles Profiler::cpuPercentiles(const std::string& name) const
+{
+    const Pass* pass = findPass(name);
+    return pass ? percentiles(pass->cpuMs) : Percentiles();
+}
+
+Profiler::Percentiles Profiler::gpuPercentiles(const std::string& name) const
+{
+    const Pass* pass = findPass(name);
+    return pass ? percentiles(pass->gpuMs) : Percentiles();
+}
+
+void Profiler::report(std::ostream& out) const
+{
+    char line[192];
+    std::snprintf(line, sizeof(line), "%-20s %26s %26s", "pass (ms)", "CPU p50 / p95 / p99", "GPU p50 / p95 / p99");
+    out << line << "\n";
+    for (const Pass& pass : passes) {
+        Percentiles cpu = percentiles(pass.cpuMs);
+        Percentiles gpu = percentiles(pass.gpuMs);
+        char gpuText[48] = "-";
+        if (gpu.samples > 0) {
+            std::snprintf(gpuText, sizeof(gpuText), "%7.3f / %7.3f / %7.3f", gpu.p50, gpu.p95, gpu.p99);
+        }
+        std::snprintf(line, sizeof(line), "%-20s %7.3f / %7.3f / %7.3f %26s",
+                      pass.name.c_str(), cpu.p50, cpu.p95, cpu.p99, gpuText);
+        out << line << "\n";
+    }
+    out.flush();
+}
+
+std::string Profiler::summary() const
+{
+    Percentiles frame = cpuPercentiles("frame");
+    char text[96];
+    std::snprintf(text, sizeof(text), "frame p50 %.2f ms, p95 %.2f ms, p99 %.2f ms", frame.p50, frame.p95, frame.p99);
+    return text;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Error::Profiler::Could not write trace: " << path << std::endl;
+        return false;
+    }
+    // Thread 1 holds the CPU scopes and thread 2 the GPU ones, so they show as two tracks
+    file << "{\"traceEvents\":[\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+         << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    char line[256];
+    for (const TraceEvent& e : events) {
+        std::snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                      passes[e.pass].name.c_str(), e.gpu ? "gpu" : "cpu", e.gpu ? 2 : 1, e.startUs, e.durationUs);
+        file << line;
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return (bool)file;
+}
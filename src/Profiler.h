@@ -0,0 +1,131 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+// Per-pass frame profiler. CPU scopes are timed with steady_clock; GPU scopes also issue a
+// GL_TIME_ELAPSED query. Every pass has kQueryBuffers queries, and a query is only read
+// back kQueryBuffers frames after it was issued, without waiting, so the profiler never
+// stalls the pipeline (a result that is still not there is dropped). The last
+// kHistoryFrames samples of every pass feed the percentiles, and every sample is kept
+// as a trace event for writeChromeTrace().
+class Profiler
+{
+public:
+    static const int kHistoryFrames = 600;
+    static const int kQueryBuffers = 2;
+    static const size_t kMaxTraceEvents = 200000;
+
+    using Clock = std::chrono::steady_clock;
+
+    // Median and tail of a pass's recent samples, in milliseconds
+    struct Percentiles {
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        int samples = 0;
+    };
+
+    // Times a CPU section for as long as it is alive
+    class CpuScope
+    {
+    public:
+        CpuScope(Profiler& profiler, const char* name);
+        ~CpuScope();
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+
+    private:
+        Profiler& owner;
+        int pass;
+        Clock::time_point start;
+    };
+
+    // Times a CPU section and the GPU work it submits. GL_TIME_ELAPSED queries cannot
+    // nest, so a GPU scope inside another one only records its CPU time.
+    class GpuScope
+    {
+    public:
+        GpuScope(Profiler& profiler, const char* name);
+        ~GpuScope();
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        Profiler& owner;
+        int pass;
+        bool query = false;
+        Clock::time_point start;
+    };
+
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Scopes do nothing while the profiler is disabled (the default)
+    void setEnabled(bool on) { active = on; }
+    bool enabled() const { return active; }
+
+    // Call at the start of every frame: records the frame-to-frame time as the "frame"
+    // pass and collects the GPU results issued kQueryBuffers frames ago
+    void beginFrame();
+
+    // GPU time of every scope of the frame collected by the last beginFrame(), in
+    // milliseconds; negative if any of its results was missing
+    float lastGpuFrameMs() const { return gpuFrameMs; }
+
+    Percentiles cpuPercentiles(const std::string& name) const;
+    Percentiles gpuPercentiles(const std::string& name) const;
+    // One line per pass with the CPU and GPU percentiles
+    void report(std::ostream& out) const;
+    // Short frame-time summary for the window title
+    std::string summary() const;
+    // Writes every recorded sample in the Chrome trace event format (chrome://tracing,
+    // Perfetto). GPU events start at the CPU time their query was issued.
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    struct Pass {
+        std::string name;
+        std::vector<float> cpuMs;           // Ring of the last kHistoryFrames samples
+        std::vector<float> gpuMs;
+        int cpuNext = 0;
+        int gpuNext = 0;
+        GLuint queries[kQueryBuffers] = {};
+        bool issued[kQueryBuffers] = {};
+        double issuedAt[kQueryBuffers] = {}; // Trace time of the query's scope, in microseconds
+    };
+
+    struct TraceEvent {
+        int pass;
+        bool gpu;
+        double startUs;
+        double durationUs;
+    };
+
+    int passIndex(const char* name);
+    const Pass* findPass(const std::string& name) const;
+    double microseconds(Clock::time_point t) const;
+    void addCpuSample(int pass, Clock::time_point start, Clock::time_point end);
+    void addTraceEvent(int pass, bool gpu, double startUs, double durationUs);
+    static void pushSample(std::vector<float>& ring, int& next, float value);
+    static Percentiles percentiles(const std::vector<float>& ring);
+
+    bool active = false;
+    std::vector<Pass> passes;
+    std::vector<TraceEvent> events;
+    Clock::time_point epoch;
+    Clock::time_point frameStart;
+    bool frameStarted = false;
+    int slot = 0;                          // Query buffer used by this frame's GPU scopes
+    float gpuFrameMs = -1.0f;
+    bool gpuScopeOpen = false;
+    bool warnedNesting = false;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,111 @@
+#include "QualityGovernor.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // Weight of a new sample in the running average
+    const float kSmoothing = 0.1f;
+    // Step up only if the better tier is predicted to stay below this share of the budget
+    const float kUpgradeHeadroom = 0.8f;
+    // Samples averaged before any decision in a new tier
+    const int kMinSamples = 10;
+    // A step back down within this many frames of a step up counts as a bounce
+    const int kBounceFrames = 120;
+    const int kMaxUpgradeHold = 960;
+}
+
+const std::vector<QualityGovernor::Tier>& QualityGovernor::tiers()
+{
+    // Steps go first, then resolution, since halving the resolution blurs more than
+    // the banding of fewer steps shows
+    static const std::vector<Tier> list = {
+        { 1, 128, 32 },
+        { 1, 64, 16 },
+        { 1, 48, 12 },
+        { 1, 32, 8 },
+        { 2, 64, 16 },
+        { 2, 48, 12 },
+        { 2, 32, 8 },
+        { 4, 32, 8 },
+        { 4, 24, 6 },
+    };
+    return list;
+}
+
+QualityGovernor::QualityGovernor(float budget)
+    : budgetMs(budget), upgradeHold(kMinSamples)
+{
+    switchTo(kDefaultTier);
+}
+
+float QualityGovernor::cost(const Tier& tier)
+{
+    // Marched pixels times samples per ray; a dense sample also runs the shadow march
+    // (or one light-volume fetch), which weighs in at about a quarter
+    float pixels = 1.0f / (float)(tier.renderScale * tier.renderScale);
+    return pixels * (float)tier.marchSteps * (1.0f + 0.25f * (float)tier.shadowSteps / 16.0f);
+}
+
+void QualityGovernor::switchTo(int index)
+{
+    current = index;
+    samples = 0;
+    average = 0.0f;
+    // Results still in flight were measured with the previous tier
+    settleFrames = Profiler::kQueryBuffers + 1;
+}
+
+bool QualityGovernor::update(float gpuFrameMs)
+{
+    frame++;
+    if (gpuFrameMs < 0.0f) {
+        return false;
+    }
+    if (settleFrames > 0) {
+        settleFrames--;
+        return false;
+    }
+    average = samples == 0 ? gpuFrameMs : average + kSmoothing * (gpuFrameMs - average);
+    samples++;
+    if (samples < kMinSamples) {
+        return false;
+    }
+
+    int last = (int)tiers().size() - 1;
+    if (average > budgetMs && current < last) {
+        // A bounce straight back down makes the next attempt wait longer
+        if (frame - lastUpgradeFrame < kBounceFrames) {
+            upgradeHold = std::min(upgradeHold * 2, kMaxUpgradeHold);
+        }
+        switchTo(current + 1);
+        return true;
+    }
+    if (current > 0 && samples >= upgradeHold) {
+        float predicted = average * cost(tiers()[current - 1]) / cost(tiers()[current]);
+        if (predicted < budgetMs * kUpgradeHeadroom) {
+            lastUpgradeFrame = frame;
+            switchTo(current - 1);
+            return true;
+        }
+    }
+    // A tier that has held steadily for long earns quick upgrades again
+    if (samples >= kMaxUpgradeHold) {
+        upgradeHold = kMinSamples;
+    }
+    return false;
+}
+
+std::string QualityGovernor::describe() const
+{
+    const Tier& t = tier();
+    char text[128];
+    int n = std::snprintf(text, sizeof(text), "tier %d/%d (scale %d, %d steps, %d shadow), ", current + 1,
+                          (int)tiers().size(), t.renderScale, t.marchSteps, t.shadowSteps);
+    if (samples > 0) {
+        std::snprintf(text + n, sizeof(text) - n, "%.1f of %.1f ms", average, budgetMs);
+    } else {
+        std::snprintf(text + n, sizeof(text) - n, "%.1f ms budget", budgetMs);
+    }
+    return text;
+}
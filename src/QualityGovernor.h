@@ -0,0 +1,55 @@
+#ifndef QUALITYGOVERNOR_H
+#define QUALITYGOVERNOR_H
+
+#include <string>
+#include <vector>
+
+// Keeps the GPU frame time near a budget (--budget ms) by moving between quality tiers,
+// each a render scale and a pair of step counts. All of them are plain settings of
+// FramePipeline and SceneBlock, so switching costs no shader compile. It is fed the
+// GPU time of every frame from the profiler's timer queries. Over budget it steps down
+// at once. It steps up only when the better tier's estimated cost leaves a margin, so it
+// does not oscillate between two neighbours. After a change it waits until the timings
+// reflect the new tier, since timer results arrive a few frames late.
+class QualityGovernor
+{
+public:
+    struct Tier {
+        int renderScale;
+        int marchSteps;
+        int shadowSteps;
+    };
+
+    // Best first; the governor starts at kDefaultTier, the quality of the default settings
+    static const std::vector<Tier>& tiers();
+    static const int kDefaultTier = 1;
+
+    explicit QualityGovernor(float budgetMs);
+
+    // Feeds one frame's GPU time (ignored if negative); true if the tier changed
+    bool update(float gpuFrameMs);
+
+    float budget() const { return budgetMs; }
+    int tierIndex() const { return current; }
+    const Tier& tier() const { return tiers()[current]; }
+    // Smoothed GPU frame time of the current tier
+    float averageMs() const { return average; }
+    // "tier 3/9 (scale 1, 48 steps, 12 shadow), 7.9 of 8.3 ms"
+    std::string describe() const;
+
+private:
+    // Relative GPU cost of a tier, for predicting the effect of a step up
+    static float cost(const Tier& tier);
+    void switchTo(int index);
+
+    float budgetMs;
+    int current = kDefaultTier;
+    float average = 0.0f;
+    int samples = 0;                        // Since the last change
+    int settleFrames = 0;                   // Frames still timed with the previous tier
+    int upgradeHold = 0;                    // Minimum samples before the next step up
+    int frame = 0;
+    int lastUpgradeFrame = -1000000;
+};
+
+#endif // QUALITYGOVERNOR_H
@@ -0,0 +1,139 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <limits>
+
+// Small, fast, seedable generators. Each instance is independent state, so they
+// can be used from many threads without locking (unlike rand()).
+
+// SplitMix64: used to expand a single seed into well-mixed generator state
+class SplitMix64 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit SplitMix64(std::uint64_t seed = 0) : state(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+private:
+    std::uint64_t state;
+};
+
+// xoshiro256**: general-purpose 64-bit generator (Blackman & Vigna)
+class Xoshiro256 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256(std::uint64_t seed = 0) {
+        SplitMix64 sm(seed);
+        for (auto& word : s) {
+            word = sm();
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        const std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound) using Lemire's multiply-shift reduction
+    std::uint32_t below(std::uint32_t bound) {
+        return (std::uint32_t)(((operator()() >> 32) * (std::uint64_t)bound) >> 32);
+    }
+
+    // Advances by 2^128 draws; successive jumps from one seed give non-overlapping streams
+    void jump() {
+        static const std::uint64_t kJump[] = { 0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+                                               0xa9582618e03fc9aaull, 0x39abdc4529b1661cull };
+        std::uint64_t t[4] = { 0, 0, 0, 0 };
+        for (std::uint64_t word : kJump) {
+            for (int b = 0; b < 64; b++) {
+                if (word & (1ull << b)) {
+                    for (int i = 0; i < 4; i++) {
+                        t[i] ^= s[i];
+                    }
+                }
+                operator()();
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            s[i] = t[i];
+        }
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    std::uint64_t s[4];
+};
+
+// PCG32 (PCG-XSH-RR 64/32, O'Neill): 16 bytes of state and one multiply per draw.
+// Every odd increment selects an independent stream, so one seed can feed many
+// generators, one per task, without any shared state.
+class Pcg32 {
+public:
+    using result_type = std::uint32_t;
+
+    explicit Pcg32(std::uint64_t seed = 0, std::uint64_t stream = 0) : state(0), increment((stream << 1) | 1) {
+        operator()();
+        state += seed;
+        operator()();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        std::uint64_t old = state;
+        state = old * 6364136223846793005ull + increment;
+        std::uint32_t xorshifted = (std::uint32_t)(((old >> 18) ^ old) >> 27);
+        std::uint32_t rot = (std::uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+    }
+
+private:
+    std::uint64_t state;
+    std::uint64_t increment;
+};
+
+// Random bits in one draw, from the generator's range (max - min must be 2^bits - 1). The width
+// of result_type is not it: std::mt19937 yields 32 bits in a 64-bit uint_fast32_t on LP64.
+template <class Rng>
+constexpr int randomBits() {
+    int bits = 0;
+    for (std::uint64_t range = (std::uint64_t)(Rng::max() - Rng::min()); range != 0; range >>= 1) {
+        bits++;
+    }
+    return bits;
+}
+
+// Uniform float in [0, 1) from the top 24 bits of one draw. Unlike std::uniform_real_distribution
+// the result is the same on every standard library.
+template <class Rng>
+float uniformFloat(Rng& rng) {
+    constexpr int bits = randomBits<Rng>();
+    static_assert(bits >= 24, "uniformFloat needs at least 24 random bits per draw");
+    std::uint64_t draw = (std::uint64_t)(rng() - Rng::min());
+    return (float)((draw >> (bits - 24)) & 0xFFFFFFu) * (1.0f / 16777216.0f);
+}
+
+#endif // RANDOM_H
@@ -0,0 +1,102 @@
+#include "SceneUpdater.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+SceneUpdater::SceneUpdater(const SceneState& initial)
+    : current(initial), published(initial)
+{
+}
+
+SceneUpdater::~SceneUpdater()
+{
+    stop();
+}
+
+void SceneUpdater::setInput(int dolly, int strafe, int lightTurn)
+{
+    dollyInput.store(dolly, std::memory_order_relaxed);
+    strafeInput.store(strafe, std::memory_order_relaxed);
+    lightInput.store(lightTurn, std::memory_order_relaxed);
+}
+
+void SceneUpdater::start()
+{
+    if (running) {
+        return;
+    }
+    running = true;
+    worker = std::thread([this]() { run(); });
+}
+
+void SceneUpdater::stop()
+{
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void SceneUpdater::reset(const SceneState& state)
+{
+    // The back buffer belongs to the updating thread
+    assert(!running);
+    current = state;
+    published.back() = current;
+    published.publish();
+}
+
+void SceneUpdater::step(double time)
+{
+    advance(time);
+    published.back() = current;
+    published.publish();
+}
+
+const SceneState& SceneUpdater::latest()
+{
+    published.update();
+    return published.front();
+}
+
+SceneState SceneState::at(double t) const
+{
+    SceneState state = *this;
+    float dt = (float)(t - time);
+    state.time = t;
+    if (dolly != 0 || strafe != 0) {
+        // A third of the depth range per second, whatever the scene size
+        float speed = camera.depthRange / 3.0f * dt;
+        state.camera.translate(dolly * speed, strafe * speed);
+    }
+    if (lightTurn != 0) {
+        float angle = lightTurn * dt;
+        float c = std::cos(angle), s = std::sin(angle);
+        glm::vec3 d = lightDir;
+        state.lightDir = glm::vec3(c * d.x + s * d.z, d.y, -s * d.x + c * d.z);
+    }
+    return state;
+}
+
+// Moves the camera and the light by the time elapsed since the last update
+void SceneUpdater::advance(double time)
+{
+    current.dolly = dollyInput.load(std::memory_order_relaxed);
+    current.strafe = strafeInput.load(std::memory_order_relaxed);
+    current.lightTurn = lightInput.load(std::memory_order_relaxed);
+    current = current.at(time);
+}
+
+void SceneUpdater::run()
+{
+    const auto period = std::chrono::nanoseconds(1000000000 / kUpdateRate);
+    auto next = std::chrono::steady_clock::now();
+    while (running) {
+        step(glfwGetTime());
+        // A missed tick is not caught up: the next update covers the whole gap through dt
+        next = std::max(next + period, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(next);
+    }
+}
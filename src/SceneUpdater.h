@@ -0,0 +1,68 @@
+#ifndef SCENEUPDATER_H
+#define SCENEUPDATER_H
+
+#include <atomic>
+#include <thread>
+#include <glm/glm.hpp>
+#include "Camera.h"
+#include "TripleBuffer.h"
+
+// What the render loop draws that changes over time, independently of the GL state
+struct SceneState {
+    double time = 0.0;
+    Camera camera;
+    glm::vec3 lightDir = glm::vec3(0.0f, 1.0f, 0.0f);
+    // Movement keys held since `time`, as passed to SceneUpdater::setInput
+    int dolly = 0;
+    int strafe = 0;
+    int lightTurn = 0;
+
+    // The state at `t` if the held keys stay down from `time` on. The renderer draws the
+    // newest update extrapolated to its own clock, so the scene moves by the frame's real
+    // duration instead of by a whole number of update ticks.
+    SceneState at(double t) const;
+};
+
+// Advances the scene (clock, camera and light movement) and hands the result to the
+// render loop through a TripleBuffer. In the interactive loop it runs on its own thread
+// at kUpdateRate, so held keys move the scene at the same speed whatever the frame rate,
+// and the renderer always picks up the newest state without waiting. Offline runs
+// (benchmark, recording) step it from the render loop instead, at their own fixed times.
+class SceneUpdater
+{
+public:
+    static const int kUpdateRate = 240;     // Updates per second of the background thread
+
+    explicit SceneUpdater(const SceneState& initial);
+    ~SceneUpdater();
+    SceneUpdater(const SceneUpdater&) = delete;
+    SceneUpdater& operator=(const SceneUpdater&) = delete;
+
+    // Any thread: held movement keys, each -1, 0 or 1. The arrow keys dolly and strafe the
+    // camera, J and K turn the light.
+    void setInput(int dolly, int strafe, int lightTurn);
+
+    // Runs the updates on a thread that reads the GLFW clock (glfwGetTime)
+    void start();
+    void stop();
+    // Only while stopped: replaces the state, or advances it to `time` on the calling thread
+    void reset(const SceneState& state);
+    void step(double time);
+
+    // Render thread: the newest published state
+    const SceneState& latest();
+
+private:
+    void advance(double time);
+    void run();
+
+    SceneState current;                     // Owned by whichever thread updates
+    TripleBuffer<SceneState> published;
+    std::atomic<int> dollyInput{0};
+    std::atomic<int> strafeInput{0};
+    std::atomic<int> lightInput{0};
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+#endif // SCENEUPDATER_H
@@ -0,0 +1,556 @@
+#include "SceneUploader.h"
+#include "GLExtensions.h"
+#include "GpuNoise.h"
+#include "MipChain.h"
+#include "Shader.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // std140 mirror of `uniform SceneBlock` in fragment_shader.glsl
+    struct SceneBlockData {
+        float boundingCenter[3];
+        float boundingRadius;
+        int sphereCount;
+        int pad[3];
+        float sdfBoundsMin[3];
+        float sdfVoxel;
+        float sdfBoundsMax[3];
+        float sdfStaleness;
+        float lightDir[3];
+        int marchSteps;
+        int shadowSteps;
+        int pad3[3];
+        float noiseWeights[4];
+    };
+    static_assert(offsetof(SceneBlockData, sphereCount) == 16, "std140 offset of uSphereCount");
+    static_assert(offsetof(SceneBlockData, sdfBoundsMin) == 32, "std140 offset of uSdfBoundsMin");
+    static_assert(offsetof(SceneBlockData, sdfBoundsMax) == 48, "std140 offset of uSdfBoundsMax");
+    static_assert(offsetof(SceneBlockData, sdfStaleness) == 60, "std140 offset of uSdfStaleness");
+    static_assert(offsetof(SceneBlockData, lightDir) == 64, "std140 offset of uLightDir");
+    static_assert(offsetof(SceneBlockData, marchSteps) == 76, "std140 offset of uMarchSteps");
+    static_assert(offsetof(SceneBlockData, shadowSteps) == 80, "std140 offset of uShadowSteps");
+    static_assert(offsetof(SceneBlockData, noiseWeights) == 96, "std140 offset of uNoiseWeights");
+    static_assert(sizeof(SphereBVH::Node) == 32, "SphereBVH::Node must be two RGBA32F texels");
+
+    // std140 mirror of `uniform FrameBlock` in fragment_shader.glsl
+    struct FrameBlockData {
+        float resolution[2];
+        float time;
+        float pad;
+        float cameraPosition[3];
+        float cameraDepthRange;
+        float cameraForward[3];
+        float cameraTanHalfFovX;
+        float cameraRight[3];
+        float cameraTanHalfFovY;
+        float cameraUp[3];
+        float pad2;
+    };
+    static_assert(offsetof(FrameBlockData, cameraPosition) == 16, "std140 offset of uCameraPosition");
+    static_assert(offsetof(FrameBlockData, cameraUp) == 64, "std140 offset of uCameraUp");
+
+    // Number of levels in a full mip chain for the largest dimension
+    int mipLevels(int size)
+    {
+        int levels = 1;
+        while (size > 1) {
+            size >>= 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    // (Re)fills a buffer texture with RGBA32F texels
+    void uploadTextureBuffer(GLuint buffer, GLuint texture, const void* data, GLsizeiptr bytes)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<GLsizeiptr>(bytes, 16), nullptr, GL_STATIC_DRAW);
+        if (bytes > 0)
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Sphere texels are (center, radius)
+    void packSpheres(const std::vector<Sphere>& spheres, Span<float> packed)
+    {
+        for (size_t i = 0; i < spheres.size(); i++) {
+            packed[i * 4 + 0] = spheres[i].center.x;
+            packed[i * 4 + 1] = spheres[i].center.y;
+            packed[i * 4 + 2] = spheres[i].center.z;
+            packed[i * 4 + 3] = spheres[i].radius;
+        }
+    }
+}
+
+SceneUploader::SceneUploader()
+{
+    glGenBuffers(1, &sceneUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    SceneBlockData initial{};
+    initial.marchSteps = kDefaultMarchSteps;
+    initial.shadowSteps = kDefaultShadowSteps;
+    initial.noiseWeights[0] = 1.0f;
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(SceneBlockData), &initial, GL_STATIC_DRAW);
+
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    frameStride = ((GLsizeiptr)sizeof(FrameBlockData) + alignment - 1) / alignment * alignment;
+
+    glGenBuffers(1, &frameUbo);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+    if (GLExtensions::caps().bufferStorage) {
+        // Mapped once for the lifetime of the buffer; writes need no further GL calls
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, frameStride * kFrameSlots, nullptr, flags);
+        frameMapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, frameStride * kFrameSlots, flags);
+    }
+    if (!frameMapped) {
+        glBufferData(GL_UNIFORM_BUFFER, frameStride * kFrameSlots, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glGenBuffers(1, &sphereBuffer);
+    glGenTextures(1, &sphereTexture);
+    glGenBuffers(1, &bvhBuffer);
+    glGenTextures(1, &bvhTexture);
+}
+
+SceneUploader::~SceneUploader()
+{
+    for (GLsync& fence : frameFences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (frameMapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &sceneUbo);
+    glDeleteBuffers(1, &frameUbo);
+    glDeleteTextures(1, &noiseTexture);
+    glDeleteTextures(1, &noiseVolume);
+    glDeleteBuffers(1, &sphereBuffer);
+    glDeleteTextures(1, &sphereTexture);
+    glDeleteBuffers(1, &bvhBuffer);
+    glDeleteTextures(1, &bvhTexture);
+    glDeleteTextures(1, &sdfVolume);
+    releaseDynamicBuffers();
+}
+
+void SceneUploader::uploadScene(const SphereBVH& bvh, const Sphere& bounding)
+{
+    const std::vector<Sphere>& spheres = bvh.spheres();
+    const std::vector<SphereBVH::Node>& nodes = bvh.nodes();
+
+    GLint maxTexels = 65536;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if ((GLint)spheres.size() > maxTexels || (GLint)nodes.size() * 2 > maxTexels) {
+        std::cerr << "Error::SceneUploader::" << spheres.size() << " spheres exceed GL_MAX_TEXTURE_BUFFER_SIZE ("
+                  << maxTexels << ")" << std::endl;
+    }
+
+    scratch.reset();
+    Span<float> packed = scratch.allocate<float>(spheres.size() * 4);
+    packSpheres(spheres, packed);
+    uploadTextureBuffer(sphereBuffer, sphereTexture, packed.data(), (GLsizeiptr)(packed.size() * sizeof(float)));
+    uploadTextureBuffer(bvhBuffer, bvhTexture, nodes.data(), (GLsizeiptr)(nodes.size() * sizeof(SphereBVH::Node)));
+    // A new scene goes back to the static buffers until it is animated
+    releaseDynamicBuffers();
+
+    SceneBlockData data{};
+    data.boundingCenter[0] = bounding.center.x;
+    data.boundingCenter[1] = bounding.center.y;
+    data.boundingCenter[2] = bounding.center.z;
+    data.boundingRadius = bounding.radius;
+    data.sphereCount = (int)spheres.size();
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    // The SDF fields are owned by uploadSdfVolume
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, offsetof(SceneBlockData, sdfBoundsMin), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kSceneBinding, sceneUbo);
+    sceneBounding = bounding;
+}
+
+void SceneUploader::updateScene(const SphereBVH& bvh, const Sphere& bounding)
+{
+    // The packed texels live in the scratch arena, so a steady animation does not allocate
+    scratch.reset();
+    Span<float> packed = scratch.allocate<float>(bvh.spheres().size() * 4);
+    packSpheres(bvh.spheres(), packed);
+    const std::vector<SphereBVH::Node>& nodes = bvh.nodes();
+    size_t sphereBytes = packed.size() * sizeof(float);
+    size_t nodeBytes = nodes.size() * sizeof(SphereBVH::Node);
+
+    updateBytes = 0;
+    if (!dynamicScene || dynamicSpheres[0].contents.size() != sphereBytes ||
+        dynamicNodes[0].contents.size() != nodeBytes) {
+        releaseDynamicBuffers();
+        for (int slot = 0; slot < kFrameSlots; slot++) {
+            createDynamicBuffer(dynamicSpheres[slot], packed.data(), sphereBytes);
+            createDynamicBuffer(dynamicNodes[slot], nodes.data(), nodeBytes);
+        }
+        dynamicScene = true;
+        updateBytes = (GLsizeiptr)((sphereBytes + nodeBytes) * kFrameSlots);
+    } else {
+        // beginFrame has waited for the frame that last read this slot's copies
+        writeChangedRange(dynamicSpheres[frameSlot], packed.data(), sphereBytes);
+        writeChangedRange(dynamicNodes[frameSlot], nodes.data(), nodeBytes);
+    }
+    writeBoundingSphere(bounding);
+}
+
+// Allocates one slot's buffer and buffer texture and fills it. The copies are only mapped
+// when the frame slices are, since the frame fences are what keeps writes off in-flight copies.
+void SceneUploader::createDynamicBuffer(DynamicBuffer& target, const void* data, size_t bytes)
+{
+    GLsizeiptr size = std::max<GLsizeiptr>((GLsizeiptr)bytes, 16);
+    glGenBuffers(1, &target.buffer);
+    glGenTextures(1, &target.texture);
+    glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+    if (frameMapped) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_TEXTURE_BUFFER, size, nullptr, flags);
+        target.mapped = (unsigned char*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, size, flags);
+    }
+    if (!target.mapped) {
+        glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    }
+    if (bytes > 0) {
+        if (target.mapped) {
+            std::memcpy(target.mapped, data, bytes);
+        } else {
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)bytes, data);
+        }
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, target.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, target.buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    const unsigned char* bytesIn = (const unsigned char*)data;
+    target.contents.assign(bytesIn, bytesIn + bytes);
+}
+
+// Writes the texels from the first to the last one that differ from the copy's contents
+void SceneUploader::writeChangedRange(DynamicBuffer& target, const void* data, size_t bytes)
+{
+    const size_t texel = 16;
+    const unsigned char* next = (const unsigned char*)data;
+    size_t first = 0;
+    while (first < bytes && std::memcmp(next + first, target.contents.data() + first, texel) == 0) {
+        first += texel;
+    }
+    if (first >= bytes) {
+        return;
+    }
+    size_t end = bytes;
+    while (end - texel > first && std::memcmp(next + end - texel, target.contents.data() + end - texel, texel) == 0) {
+        end -= texel;
+    }
+
+    if (target.mapped) {
+        std::memcpy(target.mapped + first, next + first, end - first);
+    } else {
+        glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, (GLintptr)first, (GLsizeiptr)(end - first), next + first);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    std::memcpy(target.contents.data() + first, next + first, end - first);
+    updateBytes += (GLsizeiptr)(end - first);
+}
+
+void SceneUploader::releaseDynamicBuffers()
+{
+    for (DynamicBuffer* copies : { dynamicSpheres, dynamicNodes }) {
+        for (int slot = 0; slot < kFrameSlots; slot++) {
+            DynamicBuffer& target = copies[slot];
+            if (target.mapped) {
+                glBindBuffer(GL_TEXTURE_BUFFER, target.buffer);
+                glUnmapBuffer(GL_TEXTURE_BUFFER);
+                glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &target.buffer);
+            glDeleteTextures(1, &target.texture);
+            target = DynamicBuffer();
+        }
+    }
+    dynamicScene = false;
+}
+
+void SceneUploader::writeBoundingSphere(const Sphere& bounding)
+{
+    if (bounding.center == sceneBounding.center && bounding.radius == sceneBounding.radius) {
+        return;
+    }
+    const float data[4] = { bounding.center.x, bounding.center.y, bounding.center.z, bounding.radius };
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SceneBlockData, boundingCenter), sizeof(data), data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    sceneBounding = bounding;
+}
+
+void SceneUploader::uploadSdfVolume(const SdfVolume& sdf, float staleness)
+{
+    int size = sdf.resolution();
+    glDeleteTextures(1, &sdfVolume);
+    glGenTextures(1, &sdfVolume);
+    glBindTexture(GL_TEXTURE_3D, sdfVolume);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // Half floats hold the near-surface distances with plenty of precision at half the size
+    if (GLExtensions::caps().textureStorage) {
+        glTexStorage3D(GL_TEXTURE_3D, 1, GL_R16F, size, size, size);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, GL_RED, GL_FLOAT, sdf.data());
+    } else {
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_R16F, size, size, size, 0, GL_RED, GL_FLOAT, sdf.data());
+    }
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_3D, 0);
+
+    glm::vec3 lower = sdf.boundsMin();
+    glm::vec3 upper = sdf.boundsMax();
+    glm::vec3 voxel = sdf.voxelSize();
+    SceneBlockData data{};
+    for (int k = 0; k < 3; k++) {
+        data.sdfBoundsMin[k] = lower[k];
+        data.sdfBoundsMax[k] = upper[k];
+    }
+    data.sdfVoxel = std::max(std::max(voxel.x, voxel.y), voxel.z);
+    data.sdfStaleness = std::max(staleness, 0.0f);
+    const GLintptr offset = offsetof(SceneBlockData, sdfBoundsMin);
+    const GLsizeiptr bytes = offsetof(SceneBlockData, lightDir) - offset;
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, bytes, (const unsigned char*)&data + offset);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SceneUploader::setLightDirection(const glm::vec3& direction)
+{
+    glm::vec3 unit = glm::normalize(direction);
+    const float lightDir[3] = { unit.x, unit.y, unit.z };
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SceneBlockData, lightDir), sizeof(lightDir), lightDir);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SceneUploader::setMarchSteps(int marchSteps, int shadowSteps)
+{
+    const int steps[2] = { std::max(marchSteps, 1), std::max(shadowSteps, 0) };
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SceneBlockData, marchSteps), sizeof(steps), steps);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SceneUploader::uploadNoiseTexture(const unsigned char* texels, int width, int height, Noise::Format format,
+                                       const MipChain* mips)
+{
+    allocateNoiseTexture(width, height, format, texels);
+    finishNoiseTexture(GL_TEXTURE_2D, noiseTexture, mipLevels(std::max(width, height)), noiseTexelFormat(format), mips);
+}
+
+void SceneUploader::uploadNoiseVolume(const unsigned char* texels, int size, const MipChain* mips)
+{
+    allocateNoiseVolume(size, texels);
+    finishNoiseTexture(GL_TEXTURE_3D, noiseVolume, mipLevels(size), { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE }, mips);
+}
+
+bool SceneUploader::generateNoiseTexture(GpuNoise& noise, int width, int height, int seed)
+{
+    allocateNoiseTexture(width, height, Noise::Format::R8, nullptr);
+    if (!noise.generatePerlinTexture(noiseTexture, width, height, seed)) {
+        return false;
+    }
+    finishNoiseTexture(GL_TEXTURE_2D, noiseTexture, mipLevels(std::max(width, height)),
+                       noiseTexelFormat(Noise::Format::R8), nullptr);
+    return true;
+}
+
+bool SceneUploader::generateNoiseVolume(GpuNoise& noise, int size, int seed, const NoiseVolumeParams& params)
+{
+    allocateNoiseVolume(size, nullptr);
+    if (!noise.generatePerlinWorleyVolume(noiseVolume, size, seed, params)) {
+        return false;
+    }
+    finishNoiseTexture(GL_TEXTURE_3D, noiseVolume, mipLevels(size), { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE }, nullptr);
+    return true;
+}
+
+SceneUploader::TexelFormat SceneUploader::noiseTexelFormat(Noise::Format format)
+{
+    if (format == Noise::Format::R16) {
+        return { GL_R16, GL_RED, GL_UNSIGNED_SHORT };
+    }
+    if (format == Noise::Format::RGBA8Octaves) {
+        return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+    }
+    return { GL_R8, GL_RED, GL_UNSIGNED_BYTE };
+}
+
+// Replaces the 2D noise texture and the channel weights in SceneBlock; `texels` may be
+// null to leave level 0 for GpuNoise
+void SceneUploader::allocateNoiseTexture(int width, int height, Noise::Format format, const unsigned char* texels)
+{
+    TexelFormat texel = noiseTexelFormat(format);
+    glDeleteTextures(1, &noiseTexture);
+    glGenTextures(1, &noiseTexture);
+    glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (GLExtensions::caps().textureStorage) {
+        glTexStorage2D(GL_TEXTURE_2D, mipLevels(std::max(width, height)), texel.internalFormat, width, height);
+        if (texels) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, texel.format, texel.type, texels);
+        }
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, texel.internalFormat, width, height, 0, texel.format, texel.type, texels);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Octaves at 1x..8x the frequency, each half the amplitude of the one below, normalized
+    float weights[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    if (format == Noise::Format::RGBA8Octaves) {
+        weights[0] = 8.0f / 15.0f;
+        weights[1] = 4.0f / 15.0f;
+        weights[2] = 2.0f / 15.0f;
+        weights[3] = 1.0f / 15.0f;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, sceneUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SceneBlockData, noiseWeights), sizeof(weights), weights);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+// Replaces the noise volume; `texels` may be null to leave level 0 for GpuNoise
+void SceneUploader::allocateNoiseVolume(int size, const unsigned char* texels)
+{
+    glDeleteTextures(1, &noiseVolume);
+    glGenTextures(1, &noiseVolume);
+    glBindTexture(GL_TEXTURE_3D, noiseVolume);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (GLExtensions::caps().textureStorage) {
+        glTexStorage3D(GL_TEXTURE_3D, mipLevels(size), GL_RGBA8, size, size, size);
+        if (texels) {
+            glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+        }
+    } else {
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, size, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+// Fills the levels below 0 from a CPU mip chain, or with glGenerateMipmap when there is
+// none (or it does not have the texture's `levels`), and sets the tiling filters
+void SceneUploader::finishNoiseTexture(GLenum target, GLuint texture, int levels, const TexelFormat& texel,
+                                       const MipChain* mips)
+{
+    glBindTexture(target, texture);
+    if (mips && mips->levelCount() == levels) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        bool storage = GLExtensions::caps().textureStorage;
+        for (int i = 1; i < levels; i++) {
+            const MipChain::Level& level = mips->level(i);
+            if (target == GL_TEXTURE_3D && storage) {
+                glTexSubImage3D(target, i, 0, 0, 0, level.width, level.height, level.depth, texel.format, texel.type,
+                                mips->data(i));
+            } else if (target == GL_TEXTURE_3D) {
+                glTexImage3D(target, i, texel.internalFormat, level.width, level.height, level.depth, 0, texel.format,
+                             texel.type, mips->data(i));
+            } else if (storage) {
+                glTexSubImage2D(target, i, 0, 0, level.width, level.height, texel.format, texel.type, mips->data(i));
+            } else {
+                glTexImage2D(target, i, texel.internalFormat, level.width, level.height, 0, texel.format, texel.type,
+                             mips->data(i));
+            }
+        }
+    } else {
+        glGenerateMipmap(target);
+    }
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (target == GL_TEXTURE_3D) {
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_REPEAT);
+    }
+    glBindTexture(target, 0);
+}
+
+void SceneUploader::bindProgram(const Shader& shader) const
+{
+    shader.bindUniformBlock("SceneBlock", kSceneBinding);
+    shader.bindUniformBlock("FrameBlock", kFrameBinding);
+    shader.use();
+    shader.setInt("uNoiseTex", kNoiseTextureUnit);
+    shader.setInt("uNoiseVolume", kNoiseVolumeUnit);
+    shader.setInt("uSphereBuffer", kSphereBufferUnit);
+    shader.setInt("uBvhNodes", kBvhBufferUnit);
+    shader.setInt("uSdfVolume", kSdfVolumeUnit);
+    shader.setInt("uLightVolume", kLightVolumeUnit);
+}
+
+void SceneUploader::bindTextures() const
+{
+    glActiveTexture(GL_TEXTURE0 + kNoiseTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, noiseTexture);
+    glActiveTexture(GL_TEXTURE0 + kNoiseVolumeUnit);
+    glBindTexture(GL_TEXTURE_3D, noiseVolume);
+    glActiveTexture(GL_TEXTURE0 + kSphereBufferUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, dynamicScene ? dynamicSpheres[frameSlot].texture : sphereTexture);
+    glActiveTexture(GL_TEXTURE0 + kBvhBufferUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, dynamicScene ? dynamicNodes[frameSlot].texture : bvhTexture);
+    glActiveTexture(GL_TEXTURE0 + kSdfVolumeUnit);
+    glBindTexture(GL_TEXTURE_3D, sdfVolume);
+}
+
+void SceneUploader::beginFrame(float time, int width, int height)
+{
+    frameSlot = (frameSlot + 1) % kFrameSlots;
+    GLintptr offset = frameStride * frameSlot;
+
+    FrameBlockData data{};
+    data.resolution[0] = (float)width;
+    data.resolution[1] = (float)height;
+    data.time = time;
+    for (int k = 0; k < 3; k++) {
+        data.cameraPosition[k] = view.position[k];
+        data.cameraForward[k] = view.forward[k];
+        data.cameraRight[k] = view.right[k];
+        data.cameraUp[k] = view.up[k];
+    }
+    data.cameraDepthRange = view.depthRange;
+    data.cameraTanHalfFovX = view.tanHalfFov.x;
+    data.cameraTanHalfFovY = view.tanHalfFov.y;
+
+    if (frameMapped) {
+        // Wait until the GPU has finished with the frame that last used this slice
+        if (frameFences[frameSlot]) {
+            glClientWaitSync(frameFences[frameSlot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            glDeleteSync(frameFences[frameSlot]);
+            frameFences[frameSlot] = nullptr;
+        }
+        std::memcpy(frameMapped + offset, &data, sizeof(data));
+    } else {
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUbo);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(data), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, kFrameBinding, frameUbo, offset, sizeof(FrameBlockData));
+}
+
+void SceneUploader::endFrame()
+{
+    if (frameMapped) {
+        frameFences[frameSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
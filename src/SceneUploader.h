@@ -0,0 +1,140 @@
+#ifndef SCENEUPLOADER_H
+#define SCENEUPLOADER_H
+
+#include <vector>
+#include <glad/glad.h>
+#include "Camera.h"
+#include "Cloud.h"
+#include "Noise.h"
+#include "ScratchArena.h"
+#include "SdfVolume.h"
+#include "SphereBVH.h"
+
+class GpuNoise;
+class MipChain;
+class Shader;
+
+// Owns the GPU copies of the scene: the SceneBlock/FrameBlock uniform buffers, the
+// sphere BVH texture buffers, the baked SDF volume and the noise textures. Scene data and textures are
+// uploaded once; per frame only the FrameBlock (time, resolution, camera) is written, into a
+// ring of buffer slices. An animated scene keeps one copy of the sphere and node buffers per
+// slice and rewrites only the texels that changed since that copy was last used.
+class SceneUploader
+{
+public:
+    static const GLuint kSceneBinding = 0;      // Uniform buffer binding of SceneBlock
+    static const GLuint kFrameBinding = 1;      // Uniform buffer binding of FrameBlock
+    static const int kNoiseTextureUnit = 0;     // uNoiseTex
+    static const int kNoiseVolumeUnit = 1;      // uNoiseVolume
+    static const int kSphereBufferUnit = 2;     // uSphereBuffer
+    static const int kBvhBufferUnit = 3;        // uBvhNodes
+    static const int kSdfVolumeUnit = 4;        // uSdfVolume
+    static const int kLightVolumeUnit = 5;      // uLightVolume, bound by LightVolume
+    static const int kFrameSlots = 3;           // Frames the CPU may run ahead of the GPU
+    static const int kDefaultMarchSteps = 64;   // uMarchSteps until setMarchSteps is called
+    static const int kDefaultShadowSteps = 16;  // uShadowSteps
+
+    SceneUploader();
+    ~SceneUploader();
+    SceneUploader(const SceneUploader&) = delete;
+    SceneUploader& operator=(const SceneUploader&) = delete;
+
+    // Uploads the BVH nodes and its leaf-ordered spheres into texture buffers and
+    // writes the bounding sphere and sphere count into SceneBlock
+    void uploadScene(const SphereBVH& bvh, const Sphere& bounding);
+    // Writes the spheres and nodes of a refitted BVH (same counts as the last uploadScene)
+    // into this frame's copy of the scene buffers, and the bounding sphere into SceneBlock.
+    // The first call allocates kFrameSlots copies, persistently mapped when buffer storage
+    // is available; later calls only write the range of texels that differ from what the
+    // copy held. Call between beginFrame and bindTextures.
+    void updateScene(const SphereBVH& bvh, const Sphere& bounding);
+    // Bytes of sphere and node data written by the last updateScene
+    GLsizeiptr lastUpdateBytes() const { return updateBytes; }
+    // Uploads a baked distance volume (R16F) and writes its bounds into SceneBlock.
+    // `staleness` is how far the spheres may move before the next bake; the ray marcher
+    // then only skips space with the volume and takes inside tests from the BVH.
+    void uploadSdfVolume(const SdfVolume& sdf, float staleness = 0.0f);
+    // Writes the (normalized) direction towards the light into SceneBlock
+    void setLightDirection(const glm::vec3& direction);
+    // Writes the samples per ray of the fixed march (the adaptive march takes twice as many)
+    // and of the shadow march into SceneBlock
+    void setMarchSteps(int marchSteps, int shadowSteps);
+    // Allocates immutable storage (when available) and uploads a 2D noise texture, setting
+    // uNoiseWeights for its format. With `mips` the levels below 0 come from the chain
+    // instead of a glGenerateMipmap at load.
+    void uploadNoiseTexture(const unsigned char* texels, int width, int height,
+                            Noise::Format format = Noise::Format::R8, const MipChain* mips = nullptr);
+    // Allocates immutable storage (when available) and uploads an RGBA8 noise volume
+    void uploadNoiseVolume(const unsigned char* texels, int size, const MipChain* mips = nullptr);
+    // Same textures, filled on the GPU from the seed instead of uploaded (GpuNoise::supported()).
+    // False if the noise program did not build; level 0 is then undefined, so the caller
+    // replaces the texture with an upload.
+    bool generateNoiseTexture(GpuNoise& noise, int width, int height, int seed);
+    bool generateNoiseVolume(GpuNoise& noise, int size, int seed, const NoiseVolumeParams& params);
+
+    // Connects a program's uniform blocks and samplers to the bindings above
+    void bindProgram(const Shader& shader) const;
+    // Binds the noise textures and scene buffers to their units
+    void bindTextures() const;
+
+    // Camera written into every following FrameBlock
+    void setCamera(const Camera& camera) { view = camera; }
+    const Camera& camera() const { return view; }
+
+    // Writes this frame's FrameBlock and binds its slice; call once per frame before drawing
+    void beginFrame(float time, int width, int height);
+    // Fences the slice written by beginFrame so it is not overwritten while in flight
+    void endFrame();
+
+    bool usesPersistentMapping() const { return frameMapped != nullptr; }
+
+private:
+    // One frame slot's copy of a scene texture buffer
+    struct DynamicBuffer {
+        GLuint buffer = 0;
+        GLuint texture = 0;
+        unsigned char* mapped = nullptr;
+        std::vector<unsigned char> contents;    // What the copy holds, to find the changed range
+    };
+
+    void createDynamicBuffer(DynamicBuffer& target, const void* data, size_t bytes);
+    void writeChangedRange(DynamicBuffer& target, const void* data, size_t bytes);
+    void releaseDynamicBuffers();
+    void writeBoundingSphere(const Sphere& bounding);
+    // GL description of a noise texture's texels
+    struct TexelFormat {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+    };
+
+    static TexelFormat noiseTexelFormat(Noise::Format format);
+    void allocateNoiseTexture(int width, int height, Noise::Format format, const unsigned char* texels);
+    void allocateNoiseVolume(int size, const unsigned char* texels);
+    void finishNoiseTexture(GLenum target, GLuint texture, int levels, const TexelFormat& texel, const MipChain* mips);
+
+    GLuint sceneUbo = 0;
+    GLuint frameUbo = 0;
+    GLuint noiseTexture = 0;
+    GLuint noiseVolume = 0;
+    GLuint sphereBuffer = 0;          // Backing buffers and buffer textures for the BVH
+    GLuint sphereTexture = 0;
+    GLuint bvhBuffer = 0;
+    GLuint bvhTexture = 0;
+    GLuint sdfVolume = 0;
+
+    DynamicBuffer dynamicSpheres[kFrameSlots];
+    DynamicBuffer dynamicNodes[kFrameSlots];
+    bool dynamicScene = false;        // Set by updateScene, cleared by uploadScene
+    Sphere sceneBounding = { glm::vec3(0.0f), -1.0f };  // Bounding sphere in SceneBlock
+    GLsizeiptr updateBytes = 0;
+    ScratchArena scratch;             // Staging for packed texels, reset per upload
+
+    Camera view;
+    GLsizeiptr frameStride = 0;       // Slice size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    unsigned char* frameMapped = nullptr;
+    GLsync frameFences[kFrameSlots] = {};
+    int frameSlot = 0;
+};
+
+#endif // SCENEUPLOADER_H
@@ -0,0 +1,66 @@
+#include "ScratchArena.h"
+#include <algorithm>
+#include <new>
+
+namespace {
+    unsigned char* allocateBlock(size_t bytes)
+    {
+        return static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(ScratchArena::kAlignment)));
+    }
+
+    void freeBlock(unsigned char* block)
+    {
+        ::operator delete(block, std::align_val_t(ScratchArena::kAlignment));
+    }
+
+    size_t alignUp(size_t bytes)
+    {
+        return (bytes + ScratchArena::kAlignment - 1) / ScratchArena::kAlignment * ScratchArena::kAlignment;
+    }
+}
+
+ScratchArena::ScratchArena(size_t initialBytes)
+    : block(allocateBlock(alignUp(std::max<size_t>(initialBytes, kAlignment)))),
+      blockSize(alignUp(std::max<size_t>(initialBytes, kAlignment)))
+{
+    spilled.reserve(8);
+}
+
+ScratchArena::~ScratchArena()
+{
+    for (unsigned char* extra : spilled)
+        freeBlock(extra);
+    freeBlock(block);
+}
+
+void* ScratchArena::allocateBytes(size_t bytes)
+{
+    bytes = alignUp(std::max<size_t>(bytes, 1));
+    usedBytes += bytes;
+    peakBytes = std::max(peakBytes, usedBytes);
+    if (offset + bytes <= blockSize)
+    {
+        void* slice = block + offset;
+        offset += bytes;
+        return slice;
+    }
+    // Overflow: a block of its own, kept until reset() has seen the peak
+    unsigned char* extra = allocateBlock(bytes);
+    spilled.push_back(extra);
+    return extra;
+}
+
+void ScratchArena::reset()
+{
+    if (!spilled.empty())
+    {
+        for (unsigned char* extra : spilled)
+            freeBlock(extra);
+        spilled.clear();
+        freeBlock(block);
+        blockSize = alignUp(peakBytes);
+        block = allocateBlock(blockSize);
+    }
+    offset = 0;
+    usedBytes = 0;
+}
@@ -0,0 +1,52 @@
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "Span.h"
+
+// Bump allocator for temporaries that live for one frame or one scene build. allocate()
+// hands out aligned, uninitialized slices of a single block and reset() drops them all at
+// once. A pass that outgrows the block spills into extra blocks; the next reset() replaces
+// them with one block sized for that peak, so once a pass of a given size has run, repeating
+// it touches the heap no more.
+class ScratchArena
+{
+public:
+    static constexpr size_t kAlignment = 64;    // Cache line, and enough for simd::f32x8 loads
+
+    explicit ScratchArena(size_t initialBytes = 64 * 1024);
+    ~ScratchArena();
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // `count` uninitialized elements, valid until the next reset()
+    template <class T>
+    Span<T> allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "reset() runs no destructors");
+        static_assert(alignof(T) <= kAlignment, "over-aligned type");
+        return Span<T>(static_cast<T*>(allocateBytes(count * sizeof(T))), count);
+    }
+
+    // Releases every allocation and folds any spilled blocks into one
+    void reset();
+
+    size_t used() const { return usedBytes; }
+    size_t capacity() const { return blockSize; }
+    // Largest used() since construction
+    size_t peak() const { return peakBytes; }
+
+private:
+    void* allocateBytes(size_t bytes);
+
+    unsigned char* block = nullptr;
+    size_t blockSize = 0;
+    size_t offset = 0;                          // Next free byte of `block`
+    std::vector<unsigned char*> spilled;        // Extra blocks of the current pass
+    size_t usedBytes = 0;
+    size_t peakBytes = 0;
+};
+
+#endif // SCRATCHARENA_H
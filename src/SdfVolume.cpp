@@ -0,0 +1,79 @@
+#include "SdfVolume.h"
+#include "Hash.h"
+#include "SphereBVH.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+    // Identifies a sphere set and resolution so unchanged scenes are not re-baked
+    std::uint64_t hashSpheres(const std::vector<Sphere>& spheres, int resolution)
+    {
+        std::uint64_t h = fnv1a64(&resolution, sizeof(resolution));
+        for (const Sphere& s : spheres)
+        {
+            const float values[4] = { s.center.x, s.center.y, s.center.z, s.radius };
+            h = fnv1a64(values, sizeof(values), h);
+        }
+        return h;
+    }
+}
+
+bool SdfVolume::bake(const SphereBVH& bvh, int resolution)
+{
+    if (!beginBake(bvh, resolution))
+        return false;
+    bakeSlices(bvh, size);
+    return true;
+}
+
+bool SdfVolume::beginBake(const SphereBVH& bvh, int resolution)
+{
+    const std::vector<SphereBVH::Node>& nodes = bvh.nodes();
+    if (nodes.empty() || resolution <= 2 * kPadding)
+        return false;
+
+    std::uint64_t hash = hashSpheres(bvh.spheres(), resolution);
+    if (hash == sourceHash && !distances.empty())
+        return false;
+
+    // Pad the root box so the surface never touches the outermost texels
+    const SphereBVH::Node& root = nodes[0];
+    glm::vec3 rootMin(root.boundsMin[0], root.boundsMin[1], root.boundsMin[2]);
+    glm::vec3 rootMax(root.boundsMax[0], root.boundsMax[1], root.boundsMax[2]);
+    glm::vec3 voxel = (rootMax - rootMin) / (float)(resolution - 2 * kPadding);
+    lower = rootMin - voxel * (float)kPadding;
+    upper = rootMax + voxel * (float)kPadding;
+    size = resolution;
+    sourceHash = hash;
+    nextSlice = 0;
+
+    // Only the sign and the values near the surface matter to the shader, so deep
+    // interior distances are clamped a few voxels in
+    band = 4.0f * std::max(std::max(voxel.x, voxel.y), voxel.z);
+
+    distances.assign((size_t)size * size * size, 0.0f);
+    return true;
+}
+
+bool SdfVolume::bakeSlices(const SphereBVH& bvh, int count)
+{
+    int first = nextSlice;
+    int last = std::min(first + std::max(count, 0), size);
+    glm::vec3 voxel = voxelSize();
+    ThreadPool::shared().parallelFor(last - first, 1, [&](int zBegin, int zEnd) {
+        for (int k = first + zBegin; k < first + zEnd; k++)
+        {
+            for (int j = 0; j < size; j++)
+            {
+                float* out = distances.data() + ((size_t)k * size + j) * size;
+                for (int i = 0; i < size; i++)
+                {
+                    glm::vec3 p = lower + voxel * glm::vec3(i + 0.5f, j + 0.5f, k + 0.5f);
+                    out[i] = bvh.signedDistance(p, band);
+                }
+            }
+        }
+    });
+    nextSlice = last;
+    return nextSlice == size;
+}
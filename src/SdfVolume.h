@@ -0,0 +1,51 @@
+#ifndef SDFVOLUME_H
+#define SDFVOLUME_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class SphereBVH;
+
+// Signed distance to the sphere union sampled on a resolution^3 grid over the
+// cloud's bounding box. The ray marcher uses it for one-fetch inside tests and
+// for skipping empty space; it only needs re-baking when the spheres change.
+class SdfVolume
+{
+public:
+    static const int kPadding = 2;      // Voxels of empty space kept around the spheres
+
+    // Samples the distance at every texel center, in parallel over z slices.
+    // Returns false (and keeps the current data) if the spheres and resolution are unchanged.
+    bool bake(const SphereBVH& bvh, int resolution);
+
+    // The same bake spread over several calls, so a moving scene never pays for a whole
+    // volume in one frame: beginBake() sets up the box (false if unchanged, as above) and
+    // each bakeSlices() samples the next `count` z slices, returning true once the last
+    // one is done. `bvh` must be the same, unchanged tree for every call of one bake, and
+    // the data is only complete after the final slice.
+    bool beginBake(const SphereBVH& bvh, int resolution);
+    bool bakeSlices(const SphereBVH& bvh, int count);
+
+    bool empty() const { return distances.empty(); }
+    int resolution() const { return size; }
+    const float* data() const { return distances.data(); }
+    // Changes whenever the volume is re-baked from a different sphere set
+    std::uint64_t hash() const { return sourceHash; }
+
+    // World-space box covered by the texture; texel centers sit at boundsMin + (i + 0.5) * voxelSize()
+    glm::vec3 boundsMin() const { return lower; }
+    glm::vec3 boundsMax() const { return upper; }
+    glm::vec3 voxelSize() const { return (upper - lower) / (float)size; }
+
+private:
+    std::vector<float> distances;
+    int size = 0;
+    glm::vec3 lower = glm::vec3(0.0f);
+    glm::vec3 upper = glm::vec3(0.0f);
+    std::uint64_t sourceHash = 0;       // Hash of the spheres the data was baked from
+    int nextSlice = 0;                  // First z slice bakeSlices() still has to sample
+    float band = 0.0f;                  // Interior clamp distance of the current bake
+};
+
+#endif // SDFVOLUME_H
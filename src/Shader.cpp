@@ -1,68 +1,251 @@
 #include "Shader.h"
+#include "CachePaths.h"
+#include "GLExtensions.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <glm/gtc/type_ptr.hpp>
-#include <glad/glad.h>
 
 // Utility function to read the contents of a shader file
 static std::string readFileContent(const char* filepath)
 {
-    std::ifstream file;
-    file.exceptions(std::ifstream::failbit | std::ifstream::badbit); // Enable exceptions for file errors
-    std::stringstream content;
-    try {
-        file.open(filepath);
-        content << file.rdbuf(); // Read file contents into a string stream
-        file.close();
-    } catch(std::ifstream::failure& e) {
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file) {
         std::cerr << "Error::Shader::File not successfully read: " << filepath << std::endl;
+        return std::string();
     }
-    return content.str();
+    // Size the string once and read straight into it
+    std::string content((size_t)file.tellg(), '\0');
+    file.seekg(0);
+    file.read(&content[0], (std::streamsize)content.size());
+    return content;
 }
 
-// Constructor for the Shader class: Loads, compiles, and links vertex and fragment shaders
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
-{
-    // 1. Read shader source code from files
-    std::string vCode = readFileContent(vertexPath);
-    std::string fCode = readFileContent(fragmentPath);
-    const char* vShaderCode = vCode.c_str();
-    const char* fShaderCode = fCode.c_str();
-
-    // 2. Compile vertex shader
-    unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
+// Reads a shader and expands `#include "file"` lines, resolved relative to the including
+// file. Each file is inserted once; #line directives keep compiler messages pointing at
+// the original line, with the source-string number being the file's index in `included`.
+static std::string loadShaderSource(const std::filesystem::path& path, std::vector<std::filesystem::path>& included)
+{
+    int fileIndex = (int)included.size();
+    included.push_back(path.lexically_normal());
+    std::string content = readFileContent(path.string().c_str());
+    if (content.find("#include") == std::string::npos) {
+        return content;
+    }
+
+    std::string out;
+    out.reserve(content.size());
+    size_t lineStart = 0;
+    int lineNumber = 1;
+    while (lineStart < content.size()) {
+        size_t lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = content.size();
+        }
+        std::string line = content.substr(lineStart, lineEnd - lineStart);
+        size_t first = line.find_first_not_of(" \t");
+        size_t open = line.find('"');
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (first != std::string::npos && line.compare(first, 8, "#include") == 0 && close != std::string::npos) {
+            std::filesystem::path target = (path.parent_path() / line.substr(open + 1, close - open - 1)).lexically_normal();
+            if (std::find(included.begin(), included.end(), target) == included.end()) {
+                out += "#line 1 " + std::to_string(included.size()) + "\n";
+                out += loadShaderSource(target, included);
+                out += "\n#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            } else {
+                out += "\n";
+            }
+        } else {
+            out += line;
+            out += '\n';
+        }
+        lineStart = lineEnd + 1;
+        lineNumber++;
+    }
+    return out;
+}
+
+// Inserts `#define` lines after the #version line, which must stay first; a #line
+// directive keeps the numbering of the lines below unchanged
+static std::string injectDefines(const std::string& code, const Shader::Defines& defines)
+{
+    if (defines.empty()) {
+        return code;
+    }
+    size_t version = code.find("#version");
+    size_t insertAt = version == std::string::npos ? 0 : code.find('\n', version);
+    insertAt = insertAt == std::string::npos ? code.size() : insertAt + 1;
+    int nextLine = 1 + (int)std::count(code.begin(), code.begin() + insertAt, '\n');
+
+    std::string block;
+    for (const std::string& define : defines) {
+        block += "#define " + define + "\n";
+    }
+    block += "#line " + std::to_string(nextLine) + " 0\n";
+    return code.substr(0, insertAt) + block + code.substr(insertAt);
+}
+
+// Loads a shader file with its includes expanded and the defines injected
+static std::string loadShaderSource(const char* filepath, const Shader::Defines& defines)
+{
+    std::vector<std::filesystem::path> included;
+    return injectDefines(loadShaderSource(std::filesystem::path(filepath), included), defines);
+}
+
+namespace {
+    const char kBinaryMagic[4] = { 'C', 'L', 'P', 'B' };
+
+    // Header in front of a cached program binary
+    struct BinaryHeader {
+        char magic[4];
+        std::uint32_t format;
+        std::uint64_t key;
+        std::uint64_t length;
+    };
+
+    // Cache key: every stage's source plus the driver identity, since binaries are driver specific
+    std::uint64_t programKey(const std::vector<std::string>& codes)
     {
-        int success;
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-        if(!success) {
-            char infoLog[1024];
-            glGetShaderInfoLog(vertex, 1024, NULL, infoLog);
-            std::cerr << "Error::Shader::Vertex::Compilation failed\n" << infoLog << std::endl;
+        std::uint64_t h = fnv1a64(codes[0]);
+        for (size_t i = 1; i < codes.size(); i++) {
+            h = fnv1a64(codes[i], h);
         }
+        for (GLenum e : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            const char* s = (const char*)glGetString(e);
+            h = fnv1a64(std::string(s ? s : ""), h);
+        }
+        return h;
+    }
+
+    std::string binaryPath(std::uint64_t key)
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "program_%016llx.bin", (unsigned long long)key);
+        return (std::filesystem::path(cacheDirectory()) / "shaders" / name).string();
     }
 
-    // 3. Compile fragment shader
-    unsigned int fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
+    // Submits a shader stage for compilation without waiting for the result
+    unsigned int compileStage(GLenum type, const std::string& code)
     {
+        const char* src = code.c_str();
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    void checkStage(unsigned int shader)
+    {
+        if (!shader) {
+            return;
+        }
+        GLint type = 0;
+        glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+        const char* label = type == GL_VERTEX_SHADER ? "Vertex" : type == GL_FRAGMENT_SHADER ? "Fragment" : "Compute";
         int success;
-        glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
         if(!success) {
             char infoLog[1024];
-            glGetShaderInfoLog(fragment, 1024, NULL, infoLog);
-            std::cerr << "Error::Shader::Fragment::Compilation failed\n" << infoLog << std::endl;
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            std::cerr << "Error::Shader::" << label << "::Compilation failed\n" << infoLog << std::endl;
         }
     }
+}
+
+// Constructor for the Shader class: Loads, compiles, and links vertex and fragment shaders
+Shader::Shader(const char* vertexPath, const char* fragmentPath, bool async, const Defines& defines)
+{
+    // Read shader source code from files; the defines become part of the binary cache key
+    build({ { GL_VERTEX_SHADER, loadShaderSource(vertexPath, defines) },
+            { GL_FRAGMENT_SHADER, loadShaderSource(fragmentPath, defines) } }, async);
+}
 
-    // 4. Link shaders into a single shader program
+// Loads, compiles, and links a compute shader
+Shader::Shader(const char* computePath, bool async, const Defines& defines)
+{
+    build({ { GL_COMPUTE_SHADER, loadShaderSource(computePath, defines) } }, async);
+}
+
+void Shader::build(const std::vector<StageSource>& sources, bool async)
+{
+    // 1. Try the program binary cache first
     ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    const GLCapabilities& caps = GLExtensions::caps();
+    if (caps.programBinary) {
+        std::vector<std::string> codes;
+        for (const StageSource& source : sources) {
+            codes.push_back(source.code);
+        }
+        binaryKey = programKey(codes);
+        if (loadProgramBinary()) {
+            return;
+        }
+    }
+
+    // 2. Compile the stages (asynchronously under parallel shader compile)
+    for (size_t i = 0; i < sources.size(); i++) {
+        stages[i] = compileStage(sources[i].type, sources[i].code);
+    }
+
+    // 3. Link shaders into a single shader program
+    for (size_t i = 0; i < sources.size(); i++) {
+        glAttachShader(ID, stages[i]);
+    }
+    if (caps.programBinary) {
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(ID);
+
+    // 4. Without parallel compile the status queries block anyway, so finish now
+    if (!async || !caps.parallelShaderCompile) {
+        finishLink();
+    }
+}
+
+Shader::~Shader()
+{
+    for (unsigned int& stage : stages) {
+        if (stage) {
+            glDeleteShader(stage);
+        }
+    }
+    glDeleteProgram(ID);
+}
+
+// Activates the shader program
+void Shader::use() const
+{
+    glUseProgram(ID);
+}
+
+bool Shader::isReady()
+{
+    if (!ready) {
+        GLint done = GL_TRUE;
+        glGetProgramiv(ID, GL_COMPLETION_STATUS_KHR, &done);
+        if (done) {
+            finishLink();
+        }
+    }
+    return ready;
+}
+
+void Shader::wait()
+{
+    if (!ready) {
+        finishLink();
+    }
+}
+
+void Shader::finishLink()
+{
+    for (unsigned int stage : stages) {
+        checkStage(stage);
+    }
     {
         int success;
         glGetProgramiv(ID, GL_LINK_STATUS, &success);
@@ -71,59 +254,250 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
             glGetProgramInfoLog(ID, 1024, NULL, infoLog);
             std::cerr << "Error::Shader::Program::Linking failed\n" << infoLog << std::endl;
         }
+        linked = success != 0;
+    }
+
+    // Delete individual shaders after linking (no longer needed)
+    for (unsigned int& stage : stages) {
+        if (stage) {
+            glDetachShader(ID, stage);
+            glDeleteShader(stage);
+            stage = 0;
+        }
     }
+    ready = true;
 
-    // 5. Delete individual shaders after linking (no longer needed)
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    if (linked) {
+        introspect();
+        if (GLExtensions::caps().programBinary) {
+            storeProgramBinary();
+        }
+    }
 }
 
-// Activates the shader program
-void Shader::use() const
+// Loads a cached binary for binaryKey; fails if missing, stale or rejected by the driver
+bool Shader::loadProgramBinary()
 {
-    glUseProgram(ID);
+    std::ifstream file(binaryPath(binaryKey), std::ios::binary);
+    BinaryHeader header;
+    if (!file.read((char*)&header, sizeof(header)) ||
+        std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0 || header.key != binaryKey) {
+        return false;
+    }
+    std::vector<char> binary((size_t)header.length);
+    if (!file.read(binary.data(), (std::streamsize)binary.size())) {
+        return false;
+    }
+    glProgramBinary(ID, header.format, binary.data(), (GLsizei)binary.size());
+    GLint success = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Driver updates can invalidate binaries; fall back to compiling from source
+        return false;
+    }
+    linked = ready = loadedFromCache = true;
+    introspect();
+    return true;
+}
+
+void Shader::storeProgramBinary() const
+{
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary((size_t)length);
+    BinaryHeader header;
+    std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, nullptr, &format, binary.data());
+    header.format = format;
+    header.key = binaryKey;
+    header.length = (std::uint64_t)length;
+
+    std::string path = binaryPath(binaryKey);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), (std::streamsize)binary.size());
+    if (!file) {
+        std::cerr << "Error::Shader::Could not write program binary: " << path << std::endl;
+    }
+}
+
+// Queries every active uniform and uniform block once so setters never call glGetUniformLocation
+void Shader::introspect()
+{
+    uniforms.clear();
+    blocks.clear();
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> nameBuffer(std::max(maxLength, 1));
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+        // Members of uniform blocks have no location and are set through buffers instead
+        GLint location = glGetUniformLocation(ID, name.c_str());
+        if (location < 0) {
+            continue;
+        }
+        uniforms.push_back({ fnv1a64(name), location });
+        // Arrays are reported as "name[0]"; register the base name and every element
+        std::string::size_type bracket = name.find('[');
+        if (bracket != std::string::npos) {
+            std::string base = name.substr(0, bracket);
+            uniforms.push_back({ fnv1a64(base), location });
+            for (GLint e = 1; e < size; e++) {
+                std::string element = base + "[" + std::to_string(e) + "]";
+                uniforms.push_back({ fnv1a64(element), glGetUniformLocation(ID, element.c_str()) });
+            }
+        }
+    }
+    std::sort(uniforms.begin(), uniforms.end(),
+              [](const UniformEntry& a, const UniformEntry& b) { return a.nameHash < b.nameHash; });
+
+    GLint blockCount = 0, maxBlockLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockLength);
+    nameBuffer.assign(std::max(maxBlockLength, 1), '\0');
+    for (GLint i = 0; i < blockCount; i++) {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, nameBuffer.data());
+        blocks.push_back({ fnv1a64(std::string(nameBuffer.data(), length)), (unsigned int)i });
+    }
+    std::sort(blocks.begin(), blocks.end(),
+              [](const BlockEntry& a, const BlockEntry& b) { return a.nameHash < b.nameHash; });
 }
 
-// Utility functions to set uniform values in the shader program
+// Finds a uniform in the table built by introspect()
+UniformHandle Shader::uniform(const std::string &name) const
+{
+    std::uint64_t h = fnv1a64(name);
+    auto it = std::lower_bound(uniforms.begin(), uniforms.end(), h,
+                               [](const UniformEntry& e, std::uint64_t key) { return e.nameHash < key; });
+    UniformHandle handle;
+    if (it != uniforms.end() && it->nameHash == h) {
+        handle.location = it->location;
+    }
+    return handle;
+}
+
+// Finds a uniform block in the table built by introspect()
+unsigned int Shader::uniformBlock(const std::string &name) const
+{
+    std::uint64_t h = fnv1a64(name);
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), h,
+                               [](const BlockEntry& e, std::uint64_t key) { return e.nameHash < key; });
+    return (it != blocks.end() && it->nameHash == h) ? it->index : GL_INVALID_INDEX;
+}
+
+// Connects a uniform block to a buffer binding point
+bool Shader::bindUniformBlock(const std::string &name, unsigned int binding) const
+{
+    unsigned int index = uniformBlock(name);
+    if (index == GL_INVALID_INDEX) {
+        return false;
+    }
+    glUniformBlockBinding(ID, index, binding);
+    return true;
+}
+
+// Utility functions to set uniform values in the shader program.
+// The name-based setters resolve through the same table as uniform().
 
 // Sets a boolean uniform
 void Shader::setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    setBool(uniform(name), value);
 }
 
 // Sets an integer uniform
 void Shader::setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    setInt(uniform(name), value);
 }
 
 // Sets a float uniform
 void Shader::setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    setFloat(uniform(name), value);
+}
+
+// Sets a 2D vector uniform
+void Shader::setVec2(const std::string &name, const glm::vec2 &value) const
+{
+    setVec2(uniform(name), value);
 }
 
 // Sets a 3D vector uniform
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec3(uniform(name), value);
 }
 
 // Sets a 4D vector uniform
 void Shader::setVec4(const std::string &name, const glm::vec4 &value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec4(uniform(name), value);
 }
 
 // Sets a 4x4 matrix uniform
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat4(uniform(name), mat);
 }
 
-// Sets a 2D vector uniform
-void Shader::setVec2(const std::string &name, const glm::vec2 &value) const
+// Sets `count` consecutive elements of a vec4 array uniform in one call
+void Shader::setVec4Array(const std::string &name, const glm::vec4 *values, int count) const
+{
+    setVec4Array(uniform(name), values, count);
+}
+
+// Handle-based setters; invalid handles map to location -1, which GL silently ignores
+
+void Shader::setBool(UniformHandle h, bool value) const
+{
+    glUniform1i(h.location, (int)value);
+}
+
+void Shader::setInt(UniformHandle h, int value) const
+{
+    glUniform1i(h.location, value);
+}
+
+void Shader::setFloat(UniformHandle h, float value) const
+{
+    glUniform1f(h.location, value);
+}
+
+void Shader::setVec2(UniformHandle h, const glm::vec2 &value) const
+{
+    glUniform2fv(h.location, 1, glm::value_ptr(value));
+}
+
+void Shader::setVec3(UniformHandle h, const glm::vec3 &value) const
+{
+    glUniform3fv(h.location, 1, &value[0]);
+}
+
+void Shader::setVec4(UniformHandle h, const glm::vec4 &value) const
+{
+    glUniform4fv(h.location, 1, &value[0]);
+}
+
+void Shader::setMat4(UniformHandle h, const glm::mat4 &mat) const
+{
+    glUniformMatrix4fv(h.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setVec4Array(UniformHandle h, const glm::vec4 *values, int count) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    glUniform4fv(h.location, count, &values[0][0]);
 }
@@ -1,16 +1,55 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 
+// Uniform location resolved once at link time; invalid handles are ignored by the setters
+struct UniformHandle
+{
+    int location = -1;
+    bool valid() const { return location >= 0; }
+};
+
 class Shader
 {
 public:
+    // Preprocessor definitions injected after #version in every stage, "NAME" or "NAME VALUE"
+    using Defines = std::vector<std::string>;
+
     unsigned int ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // Loads the program from the binary cache when the sources and driver match, otherwise
+    // compiles and links from source. With `async` and KHR_parallel_shader_compile the
+    // constructor returns while the driver is still compiling; poll isReady() before use().
+    Shader(const char* vertexPath, const char* fragmentPath, bool async = false, const Defines& defines = {});
+    // Same for a compute program (GL 4.3)
+    Shader(const char* computePath, bool async, const Defines& defines = {});
+    ~Shader();
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
     void use() const;
+
+    // True once compilation and linking have finished (successfully or not); never blocks
+    bool isReady();
+    // Blocks until compilation and linking have finished
+    void wait();
+    // True if the program linked successfully; only meaningful once ready
+    bool isValid() const { return linked; }
+    // True if the program came from the binary cache instead of being compiled
+    bool fromBinaryCache() const { return loadedFromCache; }
+
+    // Looks up a uniform in the table built at link time (no driver call).
+    // Array uniforms can be found by their base name ("uSpheres") or element ("uSpheres[3]").
+    UniformHandle uniform(const std::string &name) const;
+    // Index of a named uniform block, or GL_INVALID_INDEX if the program does not use it
+    unsigned int uniformBlock(const std::string &name) const;
+    // Assigns a uniform block to a buffer binding point; returns false if the block is unused
+    bool bindUniformBlock(const std::string &name, unsigned int binding) const;
+
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
@@ -18,6 +57,51 @@ public:
     void setVec3(const std::string &name, const glm::vec3 &value) const;
     void setVec4(const std::string &name, const glm::vec4 &value) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
+    void setVec4Array(const std::string &name, const glm::vec4 *values, int count) const;
+
+    // Handle-based setters for the hot loop: no string hashing, no location queries
+    void setBool(UniformHandle h, bool value) const;
+    void setInt(UniformHandle h, int value) const;
+    void setFloat(UniformHandle h, float value) const;
+    void setVec2(UniformHandle h, const glm::vec2 &value) const;
+    void setVec3(UniformHandle h, const glm::vec3 &value) const;
+    void setVec4(UniformHandle h, const glm::vec4 &value) const;
+    void setMat4(UniformHandle h, const glm::mat4 &mat) const;
+    void setVec4Array(UniformHandle h, const glm::vec4 *values, int count) const;
+
+private:
+    struct UniformEntry {
+        std::uint64_t nameHash;
+        int location;
+    };
+    struct BlockEntry {
+        std::uint64_t nameHash;
+        unsigned int index;
+    };
+
+    // Stage type and expanded source
+    struct StageSource {
+        unsigned int type;
+        std::string code;
+    };
+
+    // Loads the program from the binary cache or compiles and links the given stages
+    void build(const std::vector<StageSource>& sources, bool async);
+    // Queries all active uniforms and uniform blocks once after linking
+    void introspect();
+    // Checks compile and link status, then introspects and stores the program binary
+    void finishLink();
+    bool loadProgramBinary();
+    void storeProgramBinary() const;
+
+    std::uint64_t binaryKey = 0;           // Hash of sources and driver identity
+    unsigned int stages[2] = { 0, 0 };     // Vertex and fragment (or compute) shaders until linking finishes
+    bool ready = false;
+    bool linked = false;
+    bool loadedFromCache = false;
+
+    std::vector<UniformEntry> uniforms;  // Sorted by nameHash
+    std::vector<BlockEntry> blocks;      // Sorted by nameHash
 };
 
 #endif
@@ -0,0 +1,163 @@
+#include "ShaderPermutations.h"
+#include "GLExtensions.h"
+#include <algorithm>
+#include <iostream>
+
+ShaderPermutations::ShaderPermutations(Factory build, Prepare prepare)
+    : factory(std::move(build)), prepareVariant(std::move(prepare))
+{
+}
+
+bool ShaderPermutations::parallel() const
+{
+    return GLExtensions::caps().parallelShaderCompile;
+}
+
+// The defines in their given order; callers build them the same way every time
+std::string ShaderPermutations::keyOf(const Shader::Defines& defines)
+{
+    std::string key;
+    for (const std::string& define : defines) {
+        key += define;
+        key += ';';
+    }
+    return key;
+}
+
+ShaderPermutations::Variant& ShaderPermutations::entry(const Shader::Defines& defines)
+{
+    std::string key = keyOf(defines);
+    auto it = variants.find(key);
+    if (it == variants.end()) {
+        it = variants.emplace(key, Variant()).first;
+        it->second.defines = defines;
+    }
+    return it->second;
+}
+
+void ShaderPermutations::enqueue(const std::string& key, bool urgent)
+{
+    auto queued = std::find(queue.begin(), queue.end(), key);
+    if (queued != queue.end()) {
+        if (!urgent) {
+            return;
+        }
+        queue.erase(queued);
+    }
+    if (urgent) {
+        queue.push_front(key);
+    } else {
+        queue.push_back(key);
+    }
+}
+
+// Checks the link result once and hands a good program to Prepare
+void ShaderPermutations::finish(Variant& variant)
+{
+    variant.shader->wait();
+    if (!variant.shader->isValid()) {
+        std::cerr << "Error::ShaderPermutations::Variant failed to link: " << keyOf(variant.defines) << std::endl;
+        variant.failed = true;
+        return;
+    }
+    prepareVariant(*variant.shader);
+    variant.prepared = true;
+}
+
+Shader* ShaderPermutations::find(const Shader::Defines& defines)
+{
+    Variant& variant = entry(defines);
+    if (variant.prepared) {
+        return variant.shader.get();
+    }
+    if (!variant.shader && !variant.failed && parallel()) {
+        enqueue(keyOf(defines), true);
+    }
+    return nullptr;
+}
+
+Shader* ShaderPermutations::require(const Shader::Defines& defines)
+{
+    Variant& variant = entry(defines);
+    if (!variant.shader && !variant.failed) {
+        queue.erase(std::remove(queue.begin(), queue.end(), keyOf(defines)), queue.end());
+        variant.shader = factory(defines, false);
+    }
+    if (variant.shader && !variant.prepared && !variant.failed) {
+        finish(variant);
+    }
+    return variant.prepared ? variant.shader.get() : nullptr;
+}
+
+void ShaderPermutations::prewarm(const std::vector<Shader::Defines>& list)
+{
+    if (!parallel()) {
+        return;
+    }
+    for (const Shader::Defines& defines : list) {
+        Variant& variant = entry(defines);
+        if (!variant.shader && !variant.failed) {
+            enqueue(keyOf(defines), false);
+        }
+    }
+}
+
+void ShaderPermutations::update()
+{
+    int inFlight = 0;
+    for (auto& item : variants) {
+        Variant& variant = item.second;
+        if (!variant.shader || variant.prepared || variant.failed) {
+            continue;
+        }
+        if (variant.shader->isReady()) {
+            finish(variant);
+        } else {
+            inFlight++;
+        }
+    }
+
+    // Only background builds start here; a blocking one would stall this frame
+    if (!parallel()) {
+        queue.clear();
+        return;
+    }
+    int budget = kMaxInFlight - inFlight;
+    while (budget > 0 && !queue.empty()) {
+        Variant& variant = variants[queue.front()];
+        queue.pop_front();
+        if (variant.shader || variant.failed) {
+            continue;
+        }
+        variant.shader = factory(variant.defines, true);
+        budget--;
+    }
+}
+
+void ShaderPermutations::clear()
+{
+    std::vector<std::string> rebuild;
+    for (const auto& item : variants) {
+        if (item.second.prepared) {
+            rebuild.push_back(item.first);
+        }
+    }
+    for (auto& item : variants) {
+        item.second.shader.reset();
+        item.second.prepared = false;
+        item.second.failed = false;
+    }
+    queue.clear();
+    for (const std::string& key : rebuild) {
+        enqueue(key, false);
+    }
+}
+
+int ShaderPermutations::linkedCount() const
+{
+    int count = 0;
+    for (const auto& item : variants) {
+        count += item.second.prepared ? 1 : 0;
+    }
+    return count;
+}
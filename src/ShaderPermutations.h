@@ -0,0 +1,67 @@
+#ifndef SHADERPERMUTATIONS_H
+#define SHADERPERMUTATIONS_H
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include "Shader.h"
+
+// Cache of one program's compile-time variants, keyed by their Shader::Defines. A variant
+// is built on first request or by prewarm(); until it has linked, find() returns nullptr
+// and the caller keeps drawing with its generic program. Builds go through
+// KHR_parallel_shader_compile, a few at a time, so the driver compiles them in the
+// background. Without it a build would block the frame for the whole compile and link,
+// so update() builds nothing: find() only returns variants that require() already
+// built, and prewarm() requests are dropped. Offline runs, where a blocking build costs
+// no visible frame, get every variant they need through require().
+class ShaderPermutations
+{
+public:
+    static const int kMaxInFlight = 4;      // Parallel compiles started at once
+
+    // Builds a variant; `async` asks for a non-blocking compile (see Shader)
+    using Factory = std::function<std::unique_ptr<Shader>(const Shader::Defines& defines, bool async)>;
+    // Called once per linked variant before it is returned, e.g. to bind its blocks and samplers
+    using Prepare = std::function<void(Shader&)>;
+
+    ShaderPermutations(Factory build, Prepare prepare);
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    // The linked variant, or nullptr while it is missing or compiling (it is then queued
+    // ahead of the prewarmed ones, when builds can run in the background)
+    Shader* find(const Shader::Defines& defines);
+    // The variant, built and linked before returning; nullptr if it failed to link
+    Shader* require(const Shader::Defines& defines);
+    // Queues variants that are likely to be needed soon
+    void prewarm(const std::vector<Shader::Defines>& variants);
+    // Render thread, once per frame: finishes completed builds and starts queued ones
+    void update();
+    // Drops every variant, e.g. after the sources changed; the ones that were in use are rebuilt
+    void clear();
+
+    int linkedCount() const;
+
+private:
+    struct Variant {
+        Shader::Defines defines;
+        std::unique_ptr<Shader> shader;     // Null until the build starts
+        bool prepared = false;              // Linked and passed to Prepare
+        bool failed = false;
+    };
+
+    static std::string keyOf(const Shader::Defines& defines);
+    Variant& entry(const Shader::Defines& defines);
+    void finish(Variant& variant);
+    void enqueue(const std::string& key, bool urgent);
+    bool parallel() const;
+
+    Factory factory;
+    Prepare prepareVariant;
+    std::map<std::string, Variant> variants;
+    std::deque<std::string> queue;          // Keys waiting for a build, most urgent first
+};
+
+#endif // SHADERPERMUTATIONS_H
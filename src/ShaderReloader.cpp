@@ -0,0 +1,134 @@
+#include "ShaderReloader.h"
+#include "GLExtensions.h"
+#include "Shader.h"
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <iostream>
+
+namespace {
+    // How often the directory is scanned for modified files
+    const auto kPollInterval = std::chrono::milliseconds(250);
+}
+
+ShaderReloader::ShaderReloader(std::string directory, GLFWwindow* sharedContext)
+    : dir(std::move(directory)), workerContext(sharedContext)
+{
+    scanForChanges(); // Record the initial timestamps
+    watcher = std::thread([this]() { watchLoop(); });
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    stopping = true;
+    watcher.join();
+}
+
+void ShaderReloader::watch(const std::string& label, Factory build, Install install)
+{
+    std::lock_guard<std::mutex> lock(programsMutex);
+    programs.push_back({ label, std::move(build), std::move(install), nullptr });
+}
+
+// Returns true if any .glsl file was added, removed or modified since the last scan
+bool ShaderReloader::scanForChanges()
+{
+    std::map<std::string, std::filesystem::file_time_type> current;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.path().extension() == ".glsl") {
+            current[entry.path().string()] = entry.last_write_time(ec);
+        }
+    }
+    bool changed = current != stamps;
+    stamps = std::move(current);
+    return changed;
+}
+
+void ShaderReloader::watchLoop()
+{
+    if (workerContext) {
+        glfwMakeContextCurrent(workerContext);
+    }
+    bool dirty = false;
+    while (!stopping) {
+        std::this_thread::sleep_for(kPollInterval);
+        bool changed = scanForChanges();
+        // Editors often save in several steps; rebuild once the files have settled for one interval
+        if (changed) {
+            dirty = true;
+            continue;
+        }
+        if (!dirty) {
+            continue;
+        }
+        dirty = false;
+        if (workerContext) {
+            buildOnWorker();
+        } else {
+            rebuildRequested = true;
+        }
+    }
+    if (workerContext) {
+        glfwMakeContextCurrent(nullptr);
+    }
+}
+
+// Builds every program on the shared context; the render thread only swaps the results in
+void ShaderReloader::buildOnWorker()
+{
+    // Copy the factories so the render thread is never blocked behind a compile
+    std::vector<Factory> builds;
+    {
+        std::lock_guard<std::mutex> lock(programsMutex);
+        for (const Program& program : programs) {
+            builds.push_back(program.build);
+        }
+    }
+    for (size_t i = 0; i < builds.size(); i++) {
+        std::unique_ptr<Shader> shader = builds[i](false);
+        // Make the program visible to the render context before handing it over
+        glFinish();
+        std::lock_guard<std::mutex> finishedLock(finishedMutex);
+        finished.push_back({ i, std::move(shader) });
+    }
+}
+
+void ShaderReloader::deliver(size_t index, std::unique_ptr<Shader> shader)
+{
+    Program& program = programs[index];
+    if (!shader->isValid()) {
+        std::cerr << "Error::ShaderReloader::" << program.label
+                  << " failed to build, keeping the previous program" << std::endl;
+        return;
+    }
+    std::cout << "Reloaded " << program.label << std::endl;
+    program.install(std::move(shader));
+}
+
+void ShaderReloader::update()
+{
+    std::lock_guard<std::mutex> lock(programsMutex);
+
+    // Programs finished on the worker context
+    std::vector<Finished> done;
+    {
+        std::lock_guard<std::mutex> finishedLock(finishedMutex);
+        done.swap(finished);
+    }
+    for (Finished& f : done) {
+        deliver(f.program, std::move(f.shader));
+    }
+
+    // No shared context: start rebuilds here, non-blocking when parallel compile is available
+    if (rebuildRequested.exchange(false)) {
+        bool async = GLExtensions::caps().parallelShaderCompile;
+        for (Program& program : programs) {
+            program.pending = program.build(async);
+        }
+    }
+    for (size_t i = 0; i < programs.size(); i++) {
+        if (programs[i].pending && programs[i].pending->isReady()) {
+            deliver(i, std::move(programs[i].pending));
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef SHADERRELOADER_H
+#define SHADERRELOADER_H
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Shader;
+struct GLFWwindow;
+
+// Watches a shader directory and rebuilds registered programs when a source changes,
+// without stalling the render loop. A rebuilt program is handed to its install callback
+// only if it linked; on failure the error is logged and the live program is kept.
+//
+// Rebuilds run on a background thread with a hidden context that shares objects with the
+// render context. Without one, they fall back to KHR_parallel_shader_compile polled from
+// update(), and as a last resort to a blocking compile on the render thread.
+class ShaderReloader
+{
+public:
+    // Builds a program; `async` asks for a non-blocking compile (see Shader)
+    using Factory = std::function<std::unique_ptr<Shader>(bool async)>;
+    // Receives a successfully linked replacement on the render thread
+    using Install = std::function<void(std::unique_ptr<Shader>)>;
+
+    // sharedContext: hidden window whose context shares with the render context, or nullptr
+    ShaderReloader(std::string directory, GLFWwindow* sharedContext);
+    ~ShaderReloader();
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    // Registers a program that is rebuilt whenever any .glsl file in the directory changes
+    void watch(const std::string& label, Factory build, Install install);
+
+    // Render thread, once per frame: installs finished rebuilds and starts pending ones
+    void update();
+
+private:
+    struct Program {
+        std::string label;
+        Factory build;
+        Install install;
+        std::unique_ptr<Shader> pending;   // Parallel-compile rebuild in flight
+    };
+    struct Finished {
+        size_t program;
+        std::unique_ptr<Shader> shader;
+    };
+
+    void watchLoop();
+    bool scanForChanges();
+    void buildOnWorker();
+    void deliver(size_t index, std::unique_ptr<Shader> shader);
+
+    std::string dir;
+    GLFWwindow* workerContext;
+    std::vector<Program> programs;         // `pending` is only touched on the render thread
+    std::mutex programsMutex;              // Guards registration against the worker copying factories
+    std::map<std::string, std::filesystem::file_time_type> stamps;
+
+    std::mutex finishedMutex;
+    std::vector<Finished> finished;        // Worker-built programs waiting for update()
+    std::atomic<bool> rebuildRequested{false};
+    std::atomic<bool> stopping{false};
+    std::thread watcher;
+};
+
+#endif // SHADERRELOADER_H
@@ -0,0 +1,105 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Minimal 8-lane float vector used by the CPU noise kernels.
+// Maps onto AVX2 (one __m256), SSE2 or NEON (two 128-bit halves), or a plain array.
+
+#if defined(__AVX2__) || defined(__AVX__)
+    #include <immintrin.h>
+    #define CLOUD_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define CLOUD_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define CLOUD_SIMD_NEON 1
+#endif
+
+#include <cmath>
+
+namespace simd {
+
+constexpr int kLanes = 8;
+
+#if defined(CLOUD_SIMD_AVX)
+
+struct f32x8 {
+    __m256 v;
+    static f32x8 set1(float s) { return {_mm256_set1_ps(s)}; }
+    static f32x8 load(const float* p) { return {_mm256_loadu_ps(p)}; }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+inline f32x8 operator+(f32x8 a, f32x8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline f32x8 min(f32x8 a, f32x8 b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline f32x8 max(f32x8 a, f32x8 b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline f32x8 sqrt(f32x8 a) { return {_mm256_sqrt_ps(a.v)}; }
+inline const char* name() { return "avx"; }
+
+#elif defined(CLOUD_SIMD_SSE2)
+
+struct f32x8 {
+    __m128 lo, hi;
+    static f32x8 set1(float s) { return {_mm_set1_ps(s), _mm_set1_ps(s)}; }
+    static f32x8 load(const float* p) { return {_mm_loadu_ps(p), _mm_loadu_ps(p + 4)}; }
+    void store(float* p) const { _mm_storeu_ps(p, lo); _mm_storeu_ps(p + 4, hi); }
+};
+inline f32x8 operator+(f32x8 a, f32x8 b) { return {_mm_add_ps(a.lo, b.lo), _mm_add_ps(a.hi, b.hi)}; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return {_mm_sub_ps(a.lo, b.lo), _mm_sub_ps(a.hi, b.hi)}; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return {_mm_mul_ps(a.lo, b.lo), _mm_mul_ps(a.hi, b.hi)}; }
+inline f32x8 min(f32x8 a, f32x8 b) { return {_mm_min_ps(a.lo, b.lo), _mm_min_ps(a.hi, b.hi)}; }
+inline f32x8 max(f32x8 a, f32x8 b) { return {_mm_max_ps(a.lo, b.lo), _mm_max_ps(a.hi, b.hi)}; }
+inline f32x8 sqrt(f32x8 a) { return {_mm_sqrt_ps(a.lo), _mm_sqrt_ps(a.hi)}; }
+inline const char* name() { return "sse2"; }
+
+#elif defined(CLOUD_SIMD_NEON)
+
+struct f32x8 {
+    float32x4_t lo, hi;
+    static f32x8 set1(float s) { return {vdupq_n_f32(s), vdupq_n_f32(s)}; }
+    static f32x8 load(const float* p) { return {vld1q_f32(p), vld1q_f32(p + 4)}; }
+    void store(float* p) const { vst1q_f32(p, lo); vst1q_f32(p + 4, hi); }
+};
+inline f32x8 operator+(f32x8 a, f32x8 b) { return {vaddq_f32(a.lo, b.lo), vaddq_f32(a.hi, b.hi)}; }
+inline f32x8 operator-(f32x8 a, f32x8 b) { return {vsubq_f32(a.lo, b.lo), vsubq_f32(a.hi, b.hi)}; }
+inline f32x8 operator*(f32x8 a, f32x8 b) { return {vmulq_f32(a.lo, b.lo), vmulq_f32(a.hi, b.hi)}; }
+inline f32x8 min(f32x8 a, f32x8 b) { return {vminq_f32(a.lo, b.lo), vminq_f32(a.hi, b.hi)}; }
+inline f32x8 max(f32x8 a, f32x8 b) { return {vmaxq_f32(a.lo, b.lo), vmaxq_f32(a.hi, b.hi)}; }
+#if defined(__aarch64__)
+inline f32x8 sqrt(f32x8 a) { return {vsqrtq_f32(a.lo), vsqrtq_f32(a.hi)}; }
+#else
+// 32-bit NEON has no vector square root
+inline f32x8 sqrt(f32x8 a) {
+    float t[kLanes];
+    a.store(t);
+    for (int i = 0; i < kLanes; i++) t[i] = std::sqrt(t[i]);
+    return f32x8::load(t);
+}
+#endif
+inline const char* name() { return "neon"; }
+
+#else
+
+struct f32x8 {
+    float v[kLanes];
+    static f32x8 set1(float s) { f32x8 r; for (int i = 0; i < kLanes; i++) r.v[i] = s; return r; }
+    static f32x8 load(const float* p) { f32x8 r; for (int i = 0; i < kLanes; i++) r.v[i] = p[i]; return r; }
+    void store(float* p) const { for (int i = 0; i < kLanes; i++) p[i] = v[i]; }
+};
+#define CLOUD_SIMD_LANEWISE(op, expr) \
+    inline f32x8 op(f32x8 a, f32x8 b) { f32x8 r; for (int i = 0; i < kLanes; i++) r.v[i] = (expr); return r; }
+CLOUD_SIMD_LANEWISE(operator+, a.v[i] + b.v[i])
+CLOUD_SIMD_LANEWISE(operator-, a.v[i] - b.v[i])
+CLOUD_SIMD_LANEWISE(operator*, a.v[i] * b.v[i])
+CLOUD_SIMD_LANEWISE(min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+CLOUD_SIMD_LANEWISE(max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+#undef CLOUD_SIMD_LANEWISE
+inline f32x8 sqrt(f32x8 a) { f32x8 r; for (int i = 0; i < kLanes; i++) r.v[i] = std::sqrt(a.v[i]); return r; }
+inline const char* name() { return "scalar"; }
+
+#endif
+
+} // namespace simd
+
+#endif // SIMD_H
@@ -0,0 +1,36 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Non-owning view of a contiguous array (C++17 has no std::span). The generators write
+// into a Span so callers can reuse their own vectors, ScratchArena slices or mapped memory.
+template <class T>
+class Span
+{
+public:
+    Span() = default;
+    Span(T* data, size_t size) : ptr(data), count(size) {}
+    // Any container with data() and size(), such as std::vector
+    template <class Container,
+              class = std::enable_if_t<std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>>
+    Span(Container& container) : ptr(container.data()), count(container.size()) {}
+
+    T* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { return ptr[i]; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + count; }
+
+    // The n elements starting at offset
+    Span subspan(size_t offset, size_t n) const { return Span(ptr + offset, n); }
+
+private:
+    T* ptr = nullptr;
+    size_t count = 0;
+};
+
+#endif // SPAN_H
@@ -0,0 +1,185 @@
+#include "SphereBVH.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    // Distance from p to a node's box (0 inside it)
+    float boxDistance(const glm::vec3& p, const SphereBVH::Node& node)
+    {
+        float sum = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            float q = std::max(std::max(node.boundsMin[k] - p[k], p[k] - node.boundsMax[k]), 0.0f);
+            sum += q * q;
+        }
+        return std::sqrt(sum);
+    }
+}
+
+SphereBVH::SphereBVH(const std::vector<Sphere>& spheres)
+{
+    rebuild(spheres);
+}
+
+void SphereBVH::rebuild(const std::vector<Sphere>& spheres)
+{
+    ordered.clear();
+    sourceIndex.clear();
+    flat.clear();
+    maxDepth = 0;
+    if (spheres.empty())
+        return;
+    buildIndices.resize(spheres.size());
+    std::iota(buildIndices.begin(), buildIndices.end(), 0);
+    ordered.reserve(spheres.size());
+    sourceIndex.reserve(spheres.size());
+    // A binary tree with leaves of up to kMaxLeafSpheres has fewer than 2N/leaf nodes
+    flat.reserve(2 * spheres.size() / kMaxLeafSpheres + 1);
+    build(buildIndices, 0, (int)buildIndices.size(), spheres, 1);
+}
+
+// Builds the subtree over indices[begin, end) and returns its node index.
+// Splitting at the median keeps the tree balanced, so the depth stays near log2(N / leaf).
+int SphereBVH::build(std::vector<int>& indices, int begin, int end, const std::vector<Sphere>& input, int level)
+{
+    maxDepth = std::max(maxDepth, level);
+
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    glm::vec3 centroidMin(1e30f), centroidMax(-1e30f);
+    for (int i = begin; i < end; i++)
+    {
+        const Sphere& s = input[indices[i]];
+        boundsMin = glm::min(boundsMin, s.center - glm::vec3(s.radius));
+        boundsMax = glm::max(boundsMax, s.center + glm::vec3(s.radius));
+        centroidMin = glm::min(centroidMin, s.center);
+        centroidMax = glm::max(centroidMax, s.center);
+    }
+
+    int nodeIndex = (int)flat.size();
+    flat.push_back(Node{});
+    Node& node = flat.back();
+    for (int k = 0; k < 3; k++)
+    {
+        node.boundsMin[k] = boundsMin[k];
+        node.boundsMax[k] = boundsMax[k];
+    }
+
+    int count = end - begin;
+    if (count <= kMaxLeafSpheres || level >= kMaxDepth)
+    {
+        node.leftOrFirst = (float)ordered.size();
+        node.count = (float)count;
+        for (int i = begin; i < end; i++)
+        {
+            ordered.push_back(input[indices[i]]);
+            sourceIndex.push_back(indices[i]);
+        }
+        return nodeIndex;
+    }
+
+    // Split along the axis with the widest spread of sphere centers
+    glm::vec3 extent = centroidMax - centroidMin;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    int mid = begin + count / 2;
+    std::nth_element(indices.begin() + begin, indices.begin() + mid, indices.begin() + end,
+                     [&](int a, int b) { return input[a].center[axis] < input[b].center[axis]; });
+
+    build(indices, begin, mid, input, level + 1);
+    int right = build(indices, mid, end, input, level + 1);
+    // `node` may have been invalidated by the recursive push_backs
+    flat[nodeIndex].leftOrFirst = (float)right;
+    flat[nodeIndex].count = (float)-(axis + 1);
+    return nodeIndex;
+}
+
+void SphereBVH::refit(const std::vector<Sphere>& spheres)
+{
+    if (spheres.size() != ordered.size())
+        return;
+    for (size_t i = 0; i < ordered.size(); i++)
+        ordered[i] = spheres[sourceIndex[i]];
+
+    // Children always come after their parent, so a reverse sweep sees them first
+    for (int n = (int)flat.size() - 1; n >= 0; n--)
+    {
+        Node& node = flat[n];
+        int count = (int)node.count;
+        glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+        if (count > 0)
+        {
+            int first = (int)node.leftOrFirst;
+            for (int i = first; i < first + count; i++)
+            {
+                boundsMin = glm::min(boundsMin, ordered[i].center - glm::vec3(ordered[i].radius));
+                boundsMax = glm::max(boundsMax, ordered[i].center + glm::vec3(ordered[i].radius));
+            }
+        }
+        else
+        {
+            const Node& left = flat[n + 1];
+            const Node& right = flat[(int)node.leftOrFirst];
+            for (int k = 0; k < 3; k++)
+            {
+                boundsMin[k] = std::min(left.boundsMin[k], right.boundsMin[k]);
+                boundsMax[k] = std::max(left.boundsMax[k], right.boundsMax[k]);
+            }
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            node.boundsMin[k] = boundsMin[k];
+            node.boundsMax[k] = boundsMax[k];
+        }
+    }
+}
+
+Sphere SphereBVH::boundingSphere() const
+{
+    Sphere bounding = { glm::vec3(0.0f), 0.0f };
+    if (flat.empty())
+        return bounding;
+    const Node& root = flat[0];
+    bounding.center = 0.5f * (glm::vec3(root.boundsMin[0], root.boundsMin[1], root.boundsMin[2]) +
+                              glm::vec3(root.boundsMax[0], root.boundsMax[1], root.boundsMax[2]));
+    for (const Sphere& s : ordered)
+        bounding.radius = std::max(bounding.radius, glm::length(s.center - bounding.center) + s.radius);
+    return bounding;
+}
+
+float SphereBVH::signedDistance(const glm::vec3& p, float insideBand) const
+{
+    float d = 1e6f;
+    if (flat.empty())
+        return d;
+
+    int stack[kMaxDepth];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = flat[stack[--top]];
+        // Outside a box every sphere in it is farther than the box itself. Inside one,
+        // a sphere can only lower d down to the band, so stop descending once it is reached.
+        float boxDist = boxDistance(p, node);
+        if (boxDist > 0.0f ? boxDist >= d : d <= -insideBand)
+            continue;
+
+        int count = (int)node.count;
+        if (count > 0)
+        {
+            int first = (int)node.leftOrFirst;
+            for (int i = first; i < first + count; i++)
+                d = std::min(d, glm::length(p - ordered[i].center) - ordered[i].radius);
+        }
+        else
+        {
+            int nodeIndex = (int)(&node - flat.data());
+            stack[top++] = (int)node.leftOrFirst;
+            stack[top++] = nodeIndex + 1;
+        }
+    }
+    return std::max(d, -insideBand);
+}
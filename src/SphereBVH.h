@@ -0,0 +1,58 @@
+#ifndef SPHEREBVH_H
+#define SPHEREBVH_H
+
+#include <vector>
+#include "Cloud.h"
+
+// Bounding volume hierarchy over the cloud spheres, flattened depth-first for the
+// shader: an interior node's left child is the next node, its right child is referenced
+// by index. Leaves reference a contiguous run of spheres(), which is reordered to match.
+class SphereBVH
+{
+public:
+    static const int kMaxLeafSpheres = 4;
+    static const int kMaxDepth = 32;    // Must fit the traversal stack in fragment_shader.glsl
+
+    // GPU layout, two RGBA32F texels per node. Indices are stored as floats (exact below 2^24).
+    // Leaf:     leftOrFirst = first sphere, count = number of spheres
+    // Interior: leftOrFirst = right child,  count = -(split axis + 1)
+    struct Node {
+        float boundsMin[3];
+        float leftOrFirst;
+        float boundsMax[3];
+        float count;
+    };
+
+    SphereBVH() = default;
+    explicit SphereBVH(const std::vector<Sphere>& spheres);
+
+    // Builds the tree for a new sphere set in place. The node, sphere and index storage is
+    // reused, so rebuilding for sets of a size seen before does not allocate.
+    void rebuild(const std::vector<Sphere>& spheres);
+
+    // Replaces the spheres (same count, same order as passed to the constructor) and
+    // recomputes the node boxes bottom-up, keeping the tree. Cheaper than a rebuild, and
+    // as good as one while the spheres stay near the positions the tree was built for.
+    void refit(const std::vector<Sphere>& spheres);
+    // Bounding sphere around the root box center that touches the farthest sphere
+    Sphere boundingSphere() const;
+
+    // Signed distance from p to the sphere union. Values inside are clamped at
+    // -insideBand, which lets the search stop once a sphere contains p that deeply.
+    float signedDistance(const glm::vec3& p, float insideBand) const;
+
+    const std::vector<Sphere>& spheres() const { return ordered; }
+    const std::vector<Node>& nodes() const { return flat; }
+    int depth() const { return maxDepth; }
+
+private:
+    int build(std::vector<int>& indices, int begin, int end, const std::vector<Sphere>& input, int level);
+
+    std::vector<Sphere> ordered;
+    std::vector<int> sourceIndex;       // Constructor index of each sphere in ordered
+    std::vector<int> buildIndices;      // Scratch permutation partitioned by build()
+    std::vector<Node> flat;
+    int maxDepth = 0;
+};
+
+#endif // SPHEREBVH_H
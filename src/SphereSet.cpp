@@ -0,0 +1,221 @@
+#include "SphereSet.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // |c - p| + r for the kLanes spheres starting at i
+    simd::f32x8 reach(const SphereSet& set, size_t i, simd::f32x8 px, simd::f32x8 py, simd::f32x8 pz)
+    {
+        simd::f32x8 dx = simd::f32x8::load(set.x() + i) - px;
+        simd::f32x8 dy = simd::f32x8::load(set.y() + i) - py;
+        simd::f32x8 dz = simd::f32x8::load(set.z() + i) - pz;
+        return simd::sqrt(dx * dx + dy * dy + dz * dz) + simd::f32x8::load(set.r() + i);
+    }
+
+    float horizontalMax(simd::f32x8 v)
+    {
+        alignas(32) float lanes[simd::kLanes];
+        v.store(lanes);
+        return *std::max_element(lanes, lanes + simd::kLanes);
+    }
+
+    float horizontalMin(simd::f32x8 v)
+    {
+        alignas(32) float lanes[simd::kLanes];
+        v.store(lanes);
+        return *std::min_element(lanes, lanes + simd::kLanes);
+    }
+
+    // Smallest sphere containing both a and b
+    Sphere enclose(const Sphere& a, const Sphere& b)
+    {
+        glm::vec3 axis = b.center - a.center;
+        float d = glm::length(axis);
+        if (d + b.radius <= a.radius) {
+            return a;
+        }
+        if (d + a.radius <= b.radius) {
+            return b;
+        }
+        Sphere s;
+        s.radius = 0.5f * (d + a.radius + b.radius);
+        s.center = a.center + axis * ((s.radius - a.radius) / d);
+        return s;
+    }
+
+    // Ritter's bounding sphere, extended from points to spheres: span the two spheres found
+    // by two farthest-from searches, then grow just enough to take in every sphere left out
+    Sphere ritterSphere(const SphereSet& set)
+    {
+        size_t a = set.farthestFrom(set[0].center);
+        size_t b = set.farthestFrom(set[a].center);
+        Sphere bound = enclose(set[a], set[b]);
+
+        // Most blocks lie entirely inside already; test them eight at a time first
+        for (size_t i = 0; i < set.size(); i += simd::kLanes) {
+            simd::f32x8 px = simd::f32x8::set1(bound.center.x);
+            simd::f32x8 py = simd::f32x8::set1(bound.center.y);
+            simd::f32x8 pz = simd::f32x8::set1(bound.center.z);
+            if (horizontalMax(reach(set, i, px, py, pz)) <= bound.radius) {
+                continue;
+            }
+            size_t end = std::min(i + simd::kLanes, set.size());
+            for (size_t j = i; j < end; j++) {
+                bound = enclose(bound, set[j]);
+            }
+        }
+        // Growing rounds a little each time; one exact pass makes sure nothing pokes out
+        bound.radius = set.enclosingRadius(bound.center);
+        return bound;
+    }
+}
+
+SphereSet::SphereSet(const std::vector<Sphere>& spheres)
+{
+    reserve(spheres.size());
+    for (const Sphere& s : spheres) {
+        push_back(s);
+    }
+}
+
+void SphereSet::reserve(size_t n)
+{
+    size_t padded = (n + simd::kLanes - 1) / simd::kLanes * simd::kLanes;
+    xs.reserve(padded);
+    ys.reserve(padded);
+    zs.reserve(padded);
+    rs.reserve(padded);
+}
+
+void SphereSet::push_back(const Sphere& s)
+{
+    if (count == xs.size()) {
+        xs.resize(count + simd::kLanes);
+        ys.resize(count + simd::kLanes);
+        zs.resize(count + simd::kLanes);
+        rs.resize(count + simd::kLanes);
+    }
+    xs[count] = s.center.x;
+    ys[count] = s.center.y;
+    zs[count] = s.center.z;
+    rs[count] = s.radius;
+    count++;
+    pad();
+}
+
+void SphereSet::clear()
+{
+    xs.clear();
+    ys.clear();
+    zs.clear();
+    rs.clear();
+    count = 0;
+}
+
+// Repeats the last sphere over the unused lanes of the final vector
+void SphereSet::pad()
+{
+    for (size_t i = count; i < xs.size(); i++) {
+        xs[i] = xs[count - 1];
+        ys[i] = ys[count - 1];
+        zs[i] = zs[count - 1];
+        rs[i] = rs[count - 1];
+    }
+}
+
+std::vector<Sphere> SphereSet::toSpheres() const
+{
+    std::vector<Sphere> spheres(count);
+    for (size_t i = 0; i < count; i++) {
+        spheres[i] = (*this)[i];
+    }
+    return spheres;
+}
+
+void SphereSet::toSpheres(std::vector<Sphere>& out) const
+{
+    out.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (*this)[i];
+    }
+}
+
+void SphereSet::bounds(glm::vec3& lower, glm::vec3& upper) const
+{
+    if (empty()) {
+        lower = upper = glm::vec3(0.0f);
+        return;
+    }
+    simd::f32x8 loX = simd::f32x8::load(xs.data()) - simd::f32x8::load(rs.data());
+    simd::f32x8 loY = simd::f32x8::load(ys.data()) - simd::f32x8::load(rs.data());
+    simd::f32x8 loZ = simd::f32x8::load(zs.data()) - simd::f32x8::load(rs.data());
+    simd::f32x8 hiX = simd::f32x8::load(xs.data()) + simd::f32x8::load(rs.data());
+    simd::f32x8 hiY = simd::f32x8::load(ys.data()) + simd::f32x8::load(rs.data());
+    simd::f32x8 hiZ = simd::f32x8::load(zs.data()) + simd::f32x8::load(rs.data());
+    for (size_t i = simd::kLanes; i < xs.size(); i += simd::kLanes) {
+        simd::f32x8 r = simd::f32x8::load(rs.data() + i);
+        simd::f32x8 x = simd::f32x8::load(xs.data() + i);
+        simd::f32x8 y = simd::f32x8::load(ys.data() + i);
+        simd::f32x8 z = simd::f32x8::load(zs.data() + i);
+        loX = simd::min(loX, x - r);
+        loY = simd::min(loY, y - r);
+        loZ = simd::min(loZ, z - r);
+        hiX = simd::max(hiX, x + r);
+        hiY = simd::max(hiY, y + r);
+        hiZ = simd::max(hiZ, z + r);
+    }
+    lower = glm::vec3(horizontalMin(loX), horizontalMin(loY), horizontalMin(loZ));
+    upper = glm::vec3(horizontalMax(hiX), horizontalMax(hiY), horizontalMax(hiZ));
+}
+
+float SphereSet::enclosingRadius(const glm::vec3& p) const
+{
+    if (empty()) {
+        return 0.0f;
+    }
+    simd::f32x8 px = simd::f32x8::set1(p.x);
+    simd::f32x8 py = simd::f32x8::set1(p.y);
+    simd::f32x8 pz = simd::f32x8::set1(p.z);
+    simd::f32x8 best = reach(*this, 0, px, py, pz);
+    for (size_t i = simd::kLanes; i < xs.size(); i += simd::kLanes) {
+        best = simd::max(best, reach(*this, i, px, py, pz));
+    }
+    return horizontalMax(best);
+}
+
+size_t SphereSet::farthestFrom(const glm::vec3& p) const
+{
+    simd::f32x8 px = simd::f32x8::set1(p.x);
+    simd::f32x8 py = simd::f32x8::set1(p.y);
+    simd::f32x8 pz = simd::f32x8::set1(p.z);
+    size_t best = 0;
+    float bestReach = -1.0f;
+    alignas(32) float lanes[simd::kLanes];
+    for (size_t i = 0; i < xs.size(); i += simd::kLanes) {
+        reach(*this, i, px, py, pz).store(lanes);
+        // Strictly greater, so the padding never wins over the sphere it copies
+        for (int k = 0; k < simd::kLanes; k++) {
+            if (lanes[k] > bestReach) {
+                bestReach = lanes[k];
+                best = i + k;
+            }
+        }
+    }
+    return best;
+}
+
+// Compute a bounding sphere that encompasses all spheres of the set
+Sphere computeBoundingSphere(const SphereSet& spheres, BoundingMethod method)
+{
+    Sphere box;
+    glm::vec3 lower, upper;
+    spheres.bounds(lower, upper);
+    box.center = 0.5f * (lower + upper);
+    box.radius = spheres.enclosingRadius(box.center);
+    if (method == BoundingMethod::Box || spheres.empty()) {
+        return box;
+    }
+
+    Sphere ritter = ritterSphere(spheres);
+    return ritter.radius < box.radius ? ritter : box;
+}
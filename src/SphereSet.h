@@ -0,0 +1,85 @@
+#ifndef SPHERESET_H
+#define SPHERESET_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Simd.h"
+
+// Structure to represent a sphere with a center and radius
+struct Sphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// Allocator handing out storage aligned for whole simd::f32x8 loads
+template <class T, std::size_t Alignment = 32>
+struct AlignedAllocator {
+    using value_type = T;
+    template <class U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <class U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+    void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+    template <class U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <class U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+// How computeBoundingSphere() places the sphere
+enum class BoundingMethod {
+    Box,        // Centered on the bounding box; cheap, but loose for lopsided clouds
+    Ritter      // Ritter's grow-from-extremes sphere, kept only when it is the tighter one
+};
+
+// Spheres stored as a structure of arrays: centers and radii in four aligned arrays that
+// are padded to a multiple of simd::kLanes. The padding repeats the last sphere, so min,
+// max and farthest-sphere reductions can run over whole vectors without masking.
+class SphereSet
+{
+public:
+    using FloatArray = std::vector<float, AlignedAllocator<float>>;
+
+    SphereSet() = default;
+    explicit SphereSet(const std::vector<Sphere>& spheres);
+
+    void reserve(size_t n);
+    void push_back(const Sphere& s);
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // Number of floats in each array, a multiple of simd::kLanes
+    size_t paddedSize() const { return xs.size(); }
+
+    Sphere operator[](size_t i) const { return { glm::vec3(xs[i], ys[i], zs[i]), rs[i] }; }
+    std::vector<Sphere> toSpheres() const;
+    // Same into an existing vector, reusing its storage
+    void toSpheres(std::vector<Sphere>& out) const;
+
+    const float* x() const { return xs.data(); }
+    const float* y() const { return ys.data(); }
+    const float* z() const { return zs.data(); }
+    const float* r() const { return rs.data(); }
+
+    // Axis-aligned box around every sphere (center -/+ radius); (0, 0) when empty
+    void bounds(glm::vec3& lower, glm::vec3& upper) const;
+    // Radius of the smallest sphere around p that contains every sphere: max |c - p| + r
+    float enclosingRadius(const glm::vec3& p) const;
+    // Index of the sphere reaching farthest from p (the one defining enclosingRadius)
+    size_t farthestFrom(const glm::vec3& p) const;
+
+private:
+    void pad();
+
+    FloatArray xs, ys, zs, rs;
+    size_t count = 0;
+};
+
+// Compute a bounding sphere that encompasses all spheres of the set
+Sphere computeBoundingSphere(const SphereSet& spheres, BoundingMethod method = BoundingMethod::Box);
+
+#endif // SPHERESET_H
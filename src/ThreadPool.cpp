@@ -0,0 +1,105 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+    // Set on pool worker threads so nested parallelFor calls run inline instead of deadlocking
+    thread_local bool tlsIsWorker = false;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // The caller participates, so spawn one thread fewer than requested
+    for (unsigned i = 1; i < threadCount; i++) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// Pulls chunks from the job until none are left
+void ThreadPool::runChunks(Job& job) {
+    for (;;) {
+        int begin = job.next.fetch_add(job.grain);
+        if (begin >= job.count) {
+            break;
+        }
+        int end = std::min(begin + job.grain, job.count);
+        (*job.fn)(begin, end);
+        if (job.pending.fetch_sub(end - begin) == end - begin) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    tlsIsWorker = true;
+    unsigned seen = 0;
+    for (;;) {
+        Job* job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || (current && generation != seen); });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            job = current;
+            activeWorkers++;
+        }
+        runChunks(*job);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        done.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(int count, int grain, RangeFunction fn) {
+    if (count <= 0) {
+        return;
+    }
+    grain = std::max(1, grain);
+    // Small jobs, single-threaded pools and nested calls run on the caller
+    if (workers.empty() || tlsIsWorker || count <= grain) {
+        fn(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(submitMutex);
+    Job job;
+    job.fn = &fn;
+    job.count = count;
+    job.grain = grain;
+    job.pending.store(count);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &job;
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunks(job);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // Wait for the last chunk and for every worker to let go of the job before it leaves scope
+    done.wait(lock, [&]() { return job.pending.load() == 0 && activeWorkers == 0; });
+    current = nullptr;
+}
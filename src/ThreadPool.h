@@ -0,0 +1,71 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Non-owning reference to a callable taking (begin, end). Unlike std::function it never
+// allocates, so parallelFor stays off the heap; the callable must outlive the call.
+class RangeFunction {
+public:
+    template <class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, RangeFunction>::value>>
+    RangeFunction(F&& fn)
+        : object(const_cast<void*>(static_cast<const void*>(&fn))),
+          invoke([](void* target, int begin, int end) { (*static_cast<std::remove_reference_t<F>*>(target))(begin, end); }) {}
+
+    void operator()(int begin, int end) const { invoke(object, begin, end); }
+
+private:
+    void* object;
+    void (*invoke)(void*, int, int);
+};
+
+// Fixed-size pool of worker threads used to split CPU-heavy loops (noise
+// generation, baking) across cores. The calling thread takes part in the work.
+class ThreadPool {
+public:
+    // threadCount == 0 picks std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that execute work, including the caller
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    // Runs fn(begin, end) over [0, count) in chunks of `grain` items and blocks
+    // until every chunk has finished. Calls made from inside a worker run inline.
+    void parallelFor(int count, int grain, RangeFunction fn);
+
+    // Process-wide pool shared by the generators
+    static ThreadPool& shared();
+
+private:
+    struct Job {
+        const RangeFunction* fn = nullptr;
+        int count = 0;
+        int grain = 1;
+        std::atomic<int> next{0};
+        std::atomic<int> pending{0};
+    };
+
+    void workerLoop();
+    void runChunks(Job& job);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::mutex submitMutex;            // serializes concurrent parallelFor callers
+    Job* current = nullptr;
+    unsigned generation = 0;
+    int activeWorkers = 0;             // workers currently holding `current`
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
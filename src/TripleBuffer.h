@@ -0,0 +1,50 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free hand-off of the latest value from one writer thread to one reader thread.
+// The writer fills its back slot and publishes it; the reader takes the newest
+// published slot. Neither side ever waits, and values the reader skipped are dropped.
+template <class T>
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(const T& initial = T())
+        : slots{ initial, initial, initial }
+    {
+    }
+
+    // Writer: the slot to fill before publish()
+    T& back() { return slots[backIndex]; }
+    // Writer: makes the back slot the newest value and takes over an unused slot
+    void publish()
+    {
+        int previous = middle.exchange(backIndex | kFresh, std::memory_order_acq_rel);
+        backIndex = previous & kIndexMask;
+    }
+
+    // Reader: switches to the newest value if one was published since; true if it did
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_acquire) & kFresh)) {
+            return false;
+        }
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & kIndexMask;
+        return true;
+    }
+    // Reader: the value picked up by the last update()
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static const int kIndexMask = 3;
+    static const int kFresh = 4;            // Set while the middle slot holds an unread value
+
+    T slots[3];
+    int backIndex = 0;                      // Writer only
+    std::atomic<int> middle{1};
+    int frontIndex = 2;                     // Reader only
+};
+
+#endif // TRIPLEBUFFER_H
@@ -1,120 +1,167 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <vector>
+#include <memory>
 #include <random>
+#include <string>
+#include <vector>
 
+#include "Benchmark.h"
+#include "Camera.h"
+#include "Cloud.h"
+#include "CloudAnimation.h"
+#include "CloudScene.h"
+#include "ComputeMarcher.h"
+#include "CpuRenderer.h"
+#include "FramePipeline.h"
+#include "FrameRecorder.h"
+#include "FrameScheduler.h"
+#include "GLExtensions.h"
+#include "GpuNoise.h"
+#include "LightVolume.h"
+#include "MipChain.h"
+#include "PngWriter.h"
+#include "Profiler.h"
+#include "QualityGovernor.h"
 #include "Shader.h"
 #include "Noise.h"
+#include "NoiseCache.h"
+#include "SceneUpdater.h"
+#include "SceneUploader.h"
+#include "SdfVolume.h"
+#include "ShaderPermutations.h"
+#include "ShaderReloader.h"
+#include "SphereBVH.h"
+#include "ThreadPool.h"
 
-// Structure to represent a sphere with a center and radius
-struct Sphere {
-    glm::vec3 center;
-    float radius;
-};
-
-// Function to generate a collection of spheres that form a cloud-like shape
-std::vector<Sphere> generateCloudSpheres(
-    float L, int N, float delta_ratio=0.1f, float sigma_ratio=0.2f,
-    float alpha=2.f, float beta=5.f, float base_radius_ratio=0.3f)
+// Create the window with the newest core context available, down to GL 3.3.
+// Newer contexts unlock the optional paths in GLExtensions; macOS tops out at 4.1.
+GLFWwindow* createWindowWithBestContext(int width, int height, const char* title, GLFWwindow* share = nullptr)
 {
-    std::vector<Sphere> spheres;
-    spheres.reserve(N);
-
-    // Random number generators
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> uniform01(0.0f, 1.0f);
-    auto randf = [&]() { return uniform01(gen); };
-
-    // Gaussian distribution for random positioning
-    float sigma = L * sigma_ratio;
-    std::normal_distribution<float> gaussX(L/2, sigma);
-    std::normal_distribution<float> gaussZ(L/2, sigma);
-
-    float delta = L * delta_ratio;
-    glm::vec2 center2D(L/2, L/2);
-
-    // Generate a base sphere that serves as the foundation
-    float base_y = randf() * (delta / 2.0f);
-    float dx = L/2.0f;
-    float dz = L/2.0f;
-    float max_base_radius = std::min(std::min(dx, dz), (L - base_y)*0.5f);
-    float base_radius = std::min(L * base_radius_ratio, max_base_radius);
-
-    {
-        Sphere s;
-        s.center = glm::vec3(center2D.x, base_y + base_radius, center2D.y);
-        s.radius = base_radius;
-        spheres.push_back(s);
-    }
-
-    // Beta distribution approximation using Gamma distribution
-    auto betaRand = [&](float a, float b) {
-        std::gamma_distribution<float> gaA(a, 1.0f);
-        std::gamma_distribution<float> gaB(b, 1.0f);
-        float x = gaA(gen);
-        float y = gaB(gen);
-        return x / (x + y);
-    };
-
-    // Generate additional spheres
-    for(int i=0; i<N-1; i++)
+    static const int versions[][2] = { {4, 6}, {4, 5}, {4, 3}, {4, 1}, {3, 3} };
+    for (const auto& v : versions)
     {
-        float x = std::max(0.0f, std::min(L, gaussX(gen)));
-        float z = std::max(0.0f, std::min(L, gaussZ(gen)));
-        float dx_ = std::min(x, L - x);
-        float dz_ = std::min(z, L - z);
-        float y_base = randf() * delta;
-
-        float max_radius_y = (L - y_base)*0.5f;
-        float d_max = std::min(std::min(dx_, dz_), max_radius_y);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, v[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, v[1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+        if (GLFWwindow* window = glfwCreateWindow(width, height, title, nullptr, share))
+            return window;
+    }
+    return nullptr;
+}
 
-        float min_radius = std::max(0.05f*L, base_radius*0.2f);
-        float max_radius = std::min(d_max, 0.5f*L);
+// Values of uMarchMode in fragment_shader.glsl
+enum MarchMode { kMarchFixed = 0, kMarchAdaptive = 1 };
 
-        float br = betaRand(alpha, beta);
-        float radius = min_radius + br*(max_radius - min_radius);
+const char* marchModeName(int mode)
+{
+    return mode == kMarchAdaptive ? "adaptive" : "fixed";
+}
 
-        Sphere s;
-        s.center = glm::vec3(x, y_base + radius, z);
-        s.radius = radius;
-        spheres.push_back(s);
+// Parses "a,b,c" into integers
+std::vector<int> parseIntList(const char* text)
+{
+    std::vector<int> values;
+    for (const char* p = text; *p; )
+    {
+        char* end = nullptr;
+        long value = std::strtol(p, &end, 10);
+        if (end == p)
+            break;
+        values.push_back((int)value);
+        p = *end == ',' ? end + 1 : end;
     }
-
-    return spheres;
+    return values;
 }
 
-// Compute a bounding sphere that encompasses all generated spheres
-Sphere computeBoundingSphere(const std::vector<Sphere>& spheres)
+// Parses "640x360,1280x720" into sizes
+std::vector<glm::ivec2> parseSizeList(const char* text)
 {
-    glm::vec3 minP(1e9f), maxP(-1e9f);
-
-    // Determine the minimum and maximum bounds
-    for(auto &s : spheres)
+    std::vector<glm::ivec2> sizes;
+    for (const char* p = text; *p; )
     {
-        glm::vec3 c = s.center;
-        for(int k=0; k<3; k++){
-            if(c[k] - s.radius < minP[k]) minP[k] = c[k] - s.radius;
-            if(c[k] + s.radius > maxP[k]) maxP[k] = c[k] + s.radius;
-        }
+        char* end = nullptr;
+        long width = std::strtol(p, &end, 10);
+        if (end == p || *end != 'x')
+            break;
+        long height = std::strtol(end + 1, &end, 10);
+        sizes.push_back(glm::ivec2((int)width, (int)height));
+        p = *end == ',' ? end + 1 : end;
     }
+    return sizes;
+}
 
-    // Compute the center and radius of the bounding sphere
-    glm::vec3 center = 0.5f*(minP + maxP);
-    float radius = 0.f;
-    for(auto &s : spheres)
+// Edge-triggered key: pressed() is true once per key press
+struct KeyToggle
+{
+    int key;
+    bool held = false;
+
+    bool pressed(GLFWwindow* window)
     {
-        float dist_ = glm::length(s.center - center) + s.radius;
-        if(dist_ > radius) radius = dist_;
+        bool down = glfwGetKey(window, key) == GLFW_PRESS;
+        bool edge = down && !held;
+        held = down;
+        return edge;
     }
+};
 
-    Sphere bounding;
-    bounding.center = center;
-    bounding.radius = radius;
-    return bounding;
+// Noise textures shared by the GPU passes and the CPU renderer
+const int noiseSeed = 0;
+const int noiseTextureSize = 1024;
+const int noiseVolumeSize = 64;
+
+// --animate: the spheres advance kAnimationRate times per second and the distance volume
+// (and with it the light volume) is re-baked every kSdfRebakeInterval seconds. A bake is
+// spread over kSdfBakeTicks ticks so that no single frame samples the whole volume.
+const double kAnimationRate = 30.0;
+const double kSdfRebakeInterval = 0.25;
+const int kSdfBakeTicks = 6;
+
+// --cpu-render: builds the same scene as the interactive path and renders one frame with
+// CpuRenderer, without a window or a GL context. Returns the process exit code.
+int renderOnCpu(const std::string& path, CpuRenderer::Settings settings, float L, int N, std::uint32_t seed,
+                BoundingMethod boundingMethod, int cloudCount)
+{
+    SphereSet set = generateCloudSphereSet(L, N, seed);
+    Sphere bounding = computeBoundingSphere(set, boundingMethod);
+    SphereBVH bvh(set.toSpheres());
+
+    NoiseCache noiseCache;
+    NoiseVolumeParams volumeParams;
+    MappedNoiseTexture noise2D = noiseCache.loadOrGenerate(
+        NoiseCacheKey::perlin2D(noiseTextureSize, noiseTextureSize, noiseSeed),
+        [&]() { return Noise::generatePerlinNoiseTexture(noiseTextureSize, noiseTextureSize, noiseSeed); });
+    MappedNoiseTexture volume = noiseCache.loadOrGenerate(
+        NoiseCacheKey::perlinWorley3D(noiseVolumeSize, noiseSeed, volumeParams),
+        [&]() { return Noise::generatePerlinWorleyVolume(noiseVolumeSize, noiseSeed, volumeParams); });
+
+    CpuRenderer renderer(bvh, bounding);
+    renderer.setNoiseTexture(noise2D.data(), noiseTextureSize, noiseTextureSize);
+    renderer.setNoiseVolume(volume.data(), noiseVolumeSize);
+
+    // Same placement and framing as the window would start with
+    settings.instances = CloudScene::scatter(cloudCount, seed, bounding);
+    settings.camera = Camera::framing(CloudScene::boundsOf(settings.instances, bounding));
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> rgb = renderer.render(settings);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "CPU render: " << settings.width << "x" << settings.height << " in " << ms << " ms on "
+              << ThreadPool::shared().size() << " threads (" << simd::name() << ")" << std::endl;
+    if (!writePng(path, rgb.data(), settings.width, settings.height))
+        return -1;
+    std::cout << "Wrote " << path << std::endl;
+    return 0;
 }
 
 // Define vertices for a full-screen triangle
@@ -124,8 +171,182 @@ static float vertices[] = {
     -1.0f,  3.0f, 0.0f
 };
 
-int main()
+int main(int argc, char** argv)
 {
+    // Cloud and render options: --spheres N overrides the sphere count and --seed S fixes
+    // the sphere layout, --clouds N scatters N instances of the cloud over the sky, --bounds box|ritter picks how the bounding sphere is fitted,
+    // --steps N and --shadow-steps N set the samples per ray,
+    // --march fixed|adaptive picks the initial ray-march mode and
+    // --temporal 1|2|4 marches 1, 1/4 or 1/16 of the pixels per frame and
+    // --scale 1|2|4 marches at 1/scale of the framebuffer size and upsamples;
+    // --compute starts with the tiled compute marcher (GL 4.3) and
+    // --profile [trace.json] prints per-pass timings and writes a Chrome trace on exit.
+    // --bench [out.csv] runs the offline benchmark instead of the interactive loop; the
+    // sweep is set with --bench-sizes WxH,..., --bench-spheres, --bench-steps,
+    // --bench-shadow-steps (comma-separated lists) and --bench-frames warmup,measured.
+    // --cpu-render [out.png] renders one frame on the CPU without creating a window or a
+    // GL context, at --cpu-size WxH.
+    // --record out.y4m|out.mp4 streams the frames to a Y4M file, or through ffmpeg for any
+    // other extension; the clock then advances by exactly one frame of --record-fps N each frame.
+    // --swap-interval N sets the refreshes per swap (0 = no vsync) and --fps-cap N limits the frame rate.
+    // --budget MS lets QualityGovernor pick the render scale and step counts to keep the GPU
+    // frame time under MS milliseconds, overriding --scale, --steps and --shadow-steps.
+    // --generic-shaders keeps the cloud settings as run-time uniforms instead of compiling
+    // a specialized program variant for each combination.
+    // --animate lets the wind move, grow and dissipate the spheres (not in the benchmark).
+    // --noise cpu|gpu generates the noise textures on the CPU (through the disk cache) or
+    // with a compute shader straight into the textures (GL 4.3); both give the same texels.
+    // --noise-format r8|r16|octaves picks the 2D noise texels: 8-bit, 16-bit, or four octaves
+    // packed in RGBA8 and summed by the shader in one fetch (CPU noise only).
+    // --noise-mips box|kaiser|gpu builds the CPU noise's mip chains with that filter, so no
+    // glGenerateMipmap runs at load, or leaves them to glGenerateMipmap (as GPU noise always does).
+    float L = 10.0f;
+    int N   = 20;
+    int cloudCount = 1;
+    int marchMode = kMarchFixed;
+    BoundingMethod boundingMethod = BoundingMethod::Ritter;
+    int temporalCell = 1;
+    int renderScale = 1;
+    bool useCompute = false;
+    bool profile = false;
+    std::string tracePath = "profile_trace.json";
+    std::uint32_t seed = std::random_device{}();
+    int marchSteps = SceneUploader::kDefaultMarchSteps;
+    int shadowSteps = SceneUploader::kDefaultShadowSteps;
+    bool bench = false;
+    Benchmark::Options benchOptions;
+    bool cpuRender = false;
+    std::string cpuRenderPath = "cloud_cpu.png";
+    glm::ivec2 cpuRenderSize(800, 600);
+    std::string recordPath;
+    int recordFps = 30;
+    int swapInterval = 1;
+    double fpsCap = 0.0;
+    float budgetMs = 0.0f;
+    bool specialize = true;
+    bool animate = false;
+    bool gpuNoiseRequested = false;
+    Noise::Format noiseFormat = Noise::Format::R8;
+    bool cpuMips = true;
+    MipFilter mipFilter = MipFilter::Box;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--compute") == 0)
+            useCompute = true;
+        else if (std::strcmp(argv[i], "--profile") == 0)
+        {
+            profile = true;
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                tracePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--bench") == 0)
+        {
+            bench = true;
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                benchOptions.csvPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--generic-shaders") == 0)
+            specialize = false;
+        else if (std::strcmp(argv[i], "--animate") == 0)
+            animate = true;
+        else if (std::strcmp(argv[i], "--noise") == 0 && i + 1 < argc)
+            gpuNoiseRequested = std::strcmp(argv[++i], "gpu") == 0;
+        else if (std::strcmp(argv[i], "--noise-format") == 0 && i + 1 < argc)
+        {
+            const char* name = argv[++i];
+            noiseFormat = std::strcmp(name, "r16") == 0       ? Noise::Format::R16
+                        : std::strcmp(name, "octaves") == 0   ? Noise::Format::RGBA8Octaves
+                                                              : Noise::Format::R8;
+        }
+        else if (std::strcmp(argv[i], "--noise-mips") == 0 && i + 1 < argc)
+        {
+            const char* name = argv[++i];
+            cpuMips = std::strcmp(name, "gpu") != 0;
+            mipFilter = std::strcmp(name, "kaiser") == 0 ? MipFilter::Kaiser : MipFilter::Box;
+        }
+        else if (std::strcmp(argv[i], "--cpu-render") == 0)
+        {
+            cpuRender = true;
+            if (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                cpuRenderPath = argv[++i];
+        }
+        else if (i + 1 == argc)
+            break;
+        else if (std::strcmp(argv[i], "--spheres") == 0)
+            N = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--clouds") == 0)
+            cloudCount = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--bounds") == 0)
+            boundingMethod = std::strcmp(argv[i + 1], "box") == 0 ? BoundingMethod::Box : BoundingMethod::Ritter;
+        else if (std::strcmp(argv[i], "--march") == 0)
+            marchMode = std::strcmp(argv[i + 1], "adaptive") == 0 ? kMarchAdaptive : kMarchFixed;
+        else if (std::strcmp(argv[i], "--temporal") == 0)
+            temporalCell = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--scale") == 0)
+            renderScale = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            seed = (std::uint32_t)std::strtoul(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--steps") == 0)
+            marchSteps = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--shadow-steps") == 0)
+            shadowSteps = std::max(0, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--bench-sizes") == 0)
+            benchOptions.sizes = parseSizeList(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--bench-spheres") == 0)
+            benchOptions.sphereCounts = parseIntList(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--bench-steps") == 0)
+            benchOptions.marchSteps = parseIntList(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--bench-shadow-steps") == 0)
+            benchOptions.shadowSteps = parseIntList(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--bench-frames") == 0)
+        {
+            std::vector<int> frames = parseIntList(argv[i + 1]);
+            if (frames.size() == 2)
+            {
+                benchOptions.warmupFrames = frames[0];
+                benchOptions.measuredFrames = frames[1];
+            }
+        }
+        else if (std::strcmp(argv[i], "--record") == 0)
+            recordPath = argv[i + 1];
+        else if (std::strcmp(argv[i], "--record-fps") == 0)
+            recordFps = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--swap-interval") == 0)
+            swapInterval = std::max(0, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--fps-cap") == 0)
+            fpsCap = std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--budget") == 0)
+            budgetMs = (float)std::atof(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--cpu-size") == 0)
+        {
+            std::vector<glm::ivec2> sizes = parseSizeList(argv[i + 1]);
+            if (sizes.size() == 1 && sizes[0].x > 0 && sizes[0].y > 0)
+                cpuRenderSize = sizes[0];
+        }
+    }
+    if (bench && (benchOptions.sizes.empty() || benchOptions.sphereCounts.empty() ||
+                  benchOptions.marchSteps.empty() || benchOptions.shadowSteps.empty()))
+    {
+        std::cerr << "Failed to parse the --bench-* lists" << std::endl;
+        return -1;
+    }
+    // The benchmark always uses the same spheres so runs can be compared
+    if (bench)
+        seed = benchOptions.seed;
+    else
+        std::cout << "Sphere seed: " << seed << " (--seed to reproduce)" << std::endl;
+
+    if (cpuRender)
+    {
+        CpuRenderer::Settings settings;
+        settings.width = cpuRenderSize.x;
+        settings.height = cpuRenderSize.y;
+        settings.marchSteps = marchSteps;
+        settings.shadowSteps = shadowSteps;
+        settings.adaptive = marchMode == kMarchAdaptive;
+        return renderOnCpu(cpuRenderPath, settings, L, N, seed, boundingMethod, cloudCount);
+    }
+
     // Initialize GLFW for window management
     if(!glfwInit())
     {
@@ -133,13 +354,10 @@ int main()
         return -1;
     }
 
-    // Set OpenGL version and profile mode
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    // Create GLFW window
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Cloud Ray Marching (Static Noise)", nullptr, nullptr);
+    // Create GLFW window; the benchmark renders offscreen behind a hidden one
+    if (bench)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = createWindowWithBestContext(800, 600, "Cloud Ray Marching (Static Noise)");
     if(!window)
     {
         std::cerr << "Failed to create GLFW window" << std::endl;
@@ -147,6 +365,17 @@ int main()
         return -1;
     }
     glfwMakeContextCurrent(window);
+    // Declared before every GL object of main, so it is destroyed after all of them: their
+    // destructors release GL names while the context still exists, on every return path
+    struct WindowGuard
+    {
+        GLFWwindow* window;
+        ~WindowGuard()
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+    } windowGuard{ window };
 
     // Load OpenGL function pointers using GLAD
     if(!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -155,12 +384,36 @@ int main()
         return -1;
     }
     std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+    GLExtensions::load((GLADloadproc)glfwGetProcAddress);
 
-    // Generate cloud sphere data
-    float L = 10.0f;
-    int N   = 20;
-    auto spheres = generateCloudSpheres(L, N);
-    Sphere bounding = computeBoundingSphere(spheres);
+    // CPU scopes cover the startup work as well; GPU scopes only run inside the frame loop
+    Profiler profiler;
+    // The quality governor reads the GPU timer queries, so it needs the profiler running
+    profiler.setEnabled(profile || (budgetMs > 0.0f && !bench));
+    std::vector<Sphere> spheres;
+    Sphere bounding;
+    // The shader walks this hierarchy instead of testing every sphere
+    SphereBVH bvh;
+    // Distance volume for one-fetch inside tests and empty-space skipping; bake()
+    // is a no-op until the sphere set changes
+    const int sdfResolution = 64;
+    SdfVolume sdf;
+    // Generates N spheres from the seed and rebuilds everything derived from them on the CPU.
+    // The set, the sphere list and the tree keep their storage between builds, so going
+    // back to a sphere count used before does not touch the heap.
+    SphereSet sphereSet;
+    auto buildScene = [&](int count) {
+        {
+            Profiler::CpuScope scope(profiler, "sphere generation");
+            generateCloudSphereSet(sphereSet, L, count, seed);
+            bounding = computeBoundingSphere(sphereSet, boundingMethod);
+            sphereSet.toSpheres(spheres);
+            bvh.rebuild(spheres);
+        }
+        Profiler::CpuScope scope(profiler, "sdf bake");
+        sdf.bake(bvh, sdfResolution);
+    };
+    buildScene(bench ? benchOptions.sphereCounts.front() : N);
 
     // Generate and bind Vertex Array Object (VAO) and Vertex Buffer Object (VBO)
     unsigned int VAO, VBO;
@@ -175,29 +428,607 @@ int main()
     glEnableVertexAttribArray(0);
     glBindVertexArray(0);
 
-    // Load shaders
-    Shader shader("Shader/vertex_shader.glsl", "Shader/fragment_shader.glsl");
+    // Load shaders; with parallel shader compile the driver builds the programs
+    // while the noise textures below are generated and uploaded
+    auto buildCloudVariant = [](const Shader::Defines& defines, bool async) {
+        return std::make_unique<Shader>("Shader/cloud_vertex_shader.glsl", "Shader/fragment_shader.glsl", async, defines);
+    };
+    auto buildCloudShader = [&](bool async) {
+        return buildCloudVariant({}, async);
+    };
+    auto buildLightShader = [](bool async) {
+        return std::make_unique<Shader>("Shader/vertex_shader.glsl", "Shader/light_volume_shader.glsl", async);
+    };
+    auto buildResolveShader = [](bool async) {
+        return std::make_unique<Shader>("Shader/vertex_shader.glsl", "Shader/temporal_resolve_shader.glsl", async);
+    };
+    auto buildUpsampleShader = [](bool async) {
+        return std::make_unique<Shader>("Shader/vertex_shader.glsl", "Shader/upsample_shader.glsl", async);
+    };
+    std::unique_ptr<Shader> shader = buildCloudShader(true);
+    std::unique_ptr<Shader> lightShader = buildLightShader(true);
+    std::unique_ptr<Shader> resolveShader = buildResolveShader(true);
+    std::unique_ptr<Shader> upsampleShader = buildUpsampleShader(true);
+    // The compute marcher is only built where compute shaders exist; elsewhere the
+    // fragment pass is the only path
+    auto buildComputeShader = [](bool async) {
+        return std::make_unique<Shader>("Shader/cloud_compute_shader.glsl", async);
+    };
+    std::unique_ptr<Shader> computeShader;
+    if (ComputeMarcher::supported())
+        computeShader = buildComputeShader(true);
+    std::unique_ptr<GpuNoise> gpuNoise;
+    if (gpuNoiseRequested && noiseFormat != Noise::Format::R8)
+        std::cout << "GPU noise only writes R8 textures; generating on the CPU" << std::endl;
+    else if (gpuNoiseRequested && GpuNoise::supported())
+        gpuNoise = std::make_unique<GpuNoise>();
+    else if (gpuNoiseRequested)
+        std::cout << "GPU noise needs compute shaders (GL 4.3); generating on the CPU" << std::endl;
+
+    // Scene upload stage: sphere data, bounding sphere and noise textures go to the GPU once
+    SceneUploader uploader;
+    {
+        Profiler::CpuScope scope(profiler, "scene upload");
+        uploader.uploadScene(bvh, bounding);
+        uploader.uploadSdfVolume(sdf);
+    }
+    glm::vec3 lightDir = glm::normalize(glm::vec3(1.0f, 1.0f, -0.3f));
+    uploader.setLightDirection(lightDir);
+    uploader.setMarchSteps(marchSteps, shadowSteps);
+
+    // Instances of the cloud; the camera frames all of them. The arrow keys move it.
+    CloudScene clouds(VAO);
+    Camera camera;
+    auto placeClouds = [&]() {
+        clouds.setCloudBounds(bounding);
+        clouds.setInstances(CloudScene::scatter(cloudCount, seed, bounding));
+        camera = Camera::framing(clouds.bounds());
+    };
+    placeClouds();
+    if (cloudCount > 1)
+        std::cout << "Clouds: " << cloudCount << " instances" << std::endl;
+    bool noiseGenerated = false;
+    if (gpuNoise)
+    {
+        // Nothing is generated or copied on the CPU; the first call waits for the programs
+        Profiler::CpuScope scope(profiler, "noise generation");
+        noiseGenerated = uploader.generateNoiseTexture(*gpuNoise, noiseTextureSize, noiseTextureSize, noiseSeed) &&
+                         uploader.generateNoiseVolume(*gpuNoise, noiseVolumeSize, noiseSeed, NoiseVolumeParams());
+        if (!noiseGenerated)
+            std::cout << "GPU noise failed to build; generating on the CPU" << std::endl;
+        gpuNoise.reset();
+    }
+    if (!noiseGenerated)
+    {
+        // Noise comes from the disk cache when the key matches and is uploaded straight
+        // from the file mapping; the mappings are released at the end of this scope
+        NoiseCache noiseCache;
+        NoiseVolumeParams volumeParams;
+        MappedNoiseTexture noise2D, volume;
+        {
+            // Cache hits only map the files, so this is mostly generation on the first run
+            Profiler::CpuScope scope(profiler, "noise generation");
+            noise2D = noiseCache.loadOrGenerate(
+                NoiseCacheKey::perlin2D(noiseTextureSize, noiseTextureSize, noiseSeed, noiseFormat),
+                [&]() {
+                    return Noise::generatePerlinNoiseTexture(noiseTextureSize, noiseTextureSize, noiseSeed, noiseFormat);
+                });
+            volume = noiseCache.loadOrGenerate(
+                NoiseCacheKey::perlinWorley3D(noiseVolumeSize, noiseSeed, volumeParams),
+                [&]() { return Noise::generatePerlinWorleyVolume(noiseVolumeSize, noiseSeed, volumeParams); });
+        }
+        // The chains are filtered from the mapped level 0 in parallel
+        MipChain noiseMips, volumeMips;
+        if (cpuMips)
+        {
+            Profiler::CpuScope scope(profiler, "noise mips");
+            int channels = noiseFormat == Noise::Format::RGBA8Octaves ? 4 : 1;
+            int channelBytes = noiseFormat == Noise::Format::R16 ? 2 : 1;
+            noiseMips.build(noise2D.data(), noiseTextureSize, noiseTextureSize, 1, channels, channelBytes, mipFilter);
+            volumeMips.build(volume.data(), noiseVolumeSize, noiseVolumeSize, noiseVolumeSize, 4, 1, mipFilter);
+        }
+        Profiler::CpuScope scope(profiler, "noise upload");
+        uploader.uploadNoiseTexture(noise2D.data(), noiseTextureSize, noiseTextureSize, noiseFormat,
+                                    cpuMips ? &noiseMips : nullptr);
+        uploader.uploadNoiseVolume(volume.data(), noiseVolumeSize, cpuMips ? &volumeMips : nullptr);
+    }
+    shader->wait();
+    std::cout << "Cloud program " << (shader->fromBinaryCache() ? "loaded from binary cache" : "compiled from source")
+              << std::endl;
+    uploader.bindProgram(*shader);
+    clouds.bindProgram(*shader);
+    ComputeMarcher computeMarcher;
+    if (computeShader)
+    {
+        computeShader->wait();
+        uploader.bindProgram(*computeShader);
+        clouds.bindProgram(*computeShader);
+        computeMarcher.setProgram(std::move(computeShader));
+    }
+
+    // Shadowing is baked into a light volume on the GPU and refreshed when the light,
+    // the cloud or the noise rotation change
+    const int lightVolumeSize = 64;
+    LightVolume lightVolume(lightVolumeSize, VAO);
+    lightShader->wait();
+    uploader.bindProgram(*lightShader);
+    lightVolume.setProgram(std::move(lightShader));
+
+    // N toggles between the 3D noise volume and the 2D noise texture,
+    // B between the baked distance volume and the analytic BVH distance,
+    // M between the fixed and adaptive ray-march modes,
+    // L between the baked light volume and the per-sample shadow march,
+    // T cycles the temporal mode through every pixel, 1/4 and 1/16 per frame,
+    // C between the compute and fragment cloud passes.
+    // J and K rotate the light around the vertical axis, the arrow keys move the camera.
+    bool useNoiseVolume = true;
+    bool useSdfVolume = true;
+    bool useLightVolume = true;
+    KeyToggle noiseToggle{ GLFW_KEY_N };
+    KeyToggle sdfToggle{ GLFW_KEY_B };
+    KeyToggle marchToggle{ GLFW_KEY_M };
+    KeyToggle lightToggle{ GLFW_KEY_L };
+    KeyToggle temporalToggle{ GLFW_KEY_T };
+    KeyToggle computeToggle{ GLFW_KEY_C };
+    // Applies the current settings to both cloud programs; repeated after every change and reload
+    auto applySettings = [&]() {
+        for (Shader* program : { shader.get(), computeMarcher.activeProgram() })
+        {
+            if (!program)
+                continue;
+            program->use();
+            program->setBool("uUseNoiseVolume", useNoiseVolume);
+            program->setBool("uUseSdfVolume", useSdfVolume);
+            program->setBool("uUseLightVolume", useLightVolume);
+            program->setInt("uMarchMode", marchMode);
+        }
+    };
+    applySettings();
+    std::cout << "March mode: " << marchModeName(marchMode) << std::endl;
+
+    // Variants of the fragment cloud program with the settings above and the step counts
+    // compiled in (the CLOUD_* defines in cloud_common.glsl). The generic program, which
+    // reads them from uniforms, draws whenever the matching variant is not linked yet.
+    ShaderPermutations cloudVariants(buildCloudVariant, [&](Shader& variant) {
+        uploader.bindProgram(variant);
+        clouds.bindProgram(variant);
+    });
+    auto cloudDefines = [](bool noiseVolume, bool sdfVolume, bool lightVolume, int mode, int steps, int shadow) {
+        return Shader::Defines{
+            "CLOUD_NOISE_VOLUME " + std::to_string((int)noiseVolume),
+            "CLOUD_SDF_VOLUME " + std::to_string((int)sdfVolume),
+            "CLOUD_LIGHT_VOLUME " + std::to_string((int)lightVolume),
+            "CLOUD_MARCH_MODE " + std::to_string(mode),
+            "CLOUD_MARCH_STEPS " + std::to_string(steps),
+            "CLOUD_SHADOW_STEPS " + std::to_string(shadow),
+        };
+    };
+    auto currentCloudDefines = [&]() {
+        return cloudDefines(useNoiseVolume, useSdfVolume, useLightVolume, marchMode, marchSteps, shadowSteps);
+    };
+    // Every variant one key press away from the current settings
+    auto prewarmCloudVariants = [&]() {
+        if (!specialize)
+            return;
+        int otherMode = marchMode == kMarchFixed ? kMarchAdaptive : kMarchFixed;
+        cloudVariants.prewarm({
+            cloudDefines(!useNoiseVolume, useSdfVolume, useLightVolume, marchMode, marchSteps, shadowSteps),
+            cloudDefines(useNoiseVolume, !useSdfVolume, useLightVolume, marchMode, marchSteps, shadowSteps),
+            cloudDefines(useNoiseVolume, useSdfVolume, !useLightVolume, marchMode, marchSteps, shadowSteps),
+            cloudDefines(useNoiseVolume, useSdfVolume, useLightVolume, otherMode, marchSteps, shadowSteps),
+        });
+    };
+    auto printCloudPass = [&]() {
+        if (!useCompute)
+            std::cout << "Cloud pass: fragment" << std::endl;
+        else if (computeMarcher.activeProgram())
+            std::cout << "Cloud pass: compute (" << ComputeMarcher::kTileSize << "x" << ComputeMarcher::kTileSize
+                      << " tiles)" << std::endl;
+        else
+            std::cout << "Cloud pass: fragment (compute shaders need GL 4.3)" << std::endl;
+    };
+    printCloudPass();
+
+    FramePipeline frames(VAO);
+    resolveShader->wait();
+    frames.setResolveProgram(std::move(resolveShader));
+    upsampleShader->wait();
+    frames.setUpsampleProgram(std::move(upsampleShader));
+    frames.setTemporalCell(temporalCell);
+    frames.setRenderScale(renderScale);
+
+    // Hot reload of Shader/*.glsl: rebuilt on a hidden shared context and swapped in only once linked
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* reloadContext = createWindowWithBestContext(1, 1, "", window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    glfwMakeContextCurrent(window);
+    FrameScheduler scheduler(swapInterval, fpsCap);
+    scheduler.apply();
+    auto reloader = std::make_unique<ShaderReloader>("Shader", reloadContext);
+    reloader->watch("cloud program", buildCloudShader, [&](std::unique_ptr<Shader> rebuilt) {
+        shader = std::move(rebuilt);
+        uploader.bindProgram(*shader);
+        clouds.bindProgram(*shader);
+        applySettings();
+        cloudVariants.clear();
+        frames.resetHistory();
+    });
+    if (ComputeMarcher::supported())
+    {
+        reloader->watch("cloud compute program", buildComputeShader, [&](std::unique_ptr<Shader> rebuilt) {
+            uploader.bindProgram(*rebuilt);
+            clouds.bindProgram(*rebuilt);
+            computeMarcher.setProgram(std::move(rebuilt));
+            applySettings();
+            frames.resetHistory();
+        });
+    }
+    reloader->watch("light volume program", buildLightShader, [&](std::unique_ptr<Shader> rebuilt) {
+        uploader.bindProgram(*rebuilt);
+        lightVolume.setProgram(std::move(rebuilt));
+        frames.resetHistory();
+    });
+    reloader->watch("temporal resolve program", buildResolveShader, [&](std::unique_ptr<Shader> rebuilt) {
+        frames.setResolveProgram(std::move(rebuilt));
+        frames.resetHistory();
+    });
+    reloader->watch("upsample program", buildUpsampleShader, [&](std::unique_ptr<Shader> rebuilt) {
+        frames.setUpsampleProgram(std::move(rebuilt));
+    });
 
     glEnable(GL_DEPTH_TEST);
 
+    // The benchmark drives the loop until its sweep is done; the modes picked on the
+    // command line stay fixed and are recorded with the results
+    std::unique_ptr<Benchmark> benchmark;
+    if (bench)
+    {
+        benchOptions.mode.march = marchModeName(marchMode);
+        benchOptions.mode.pass = useCompute && computeMarcher.activeProgram() ? "compute" : "fragment";
+        benchOptions.mode.temporal = frames.temporalCell();
+        benchOptions.mode.scale = frames.renderScale();
+        benchmark = std::make_unique<Benchmark>(benchOptions);
+    }
+
+    // Recording starts with the first frame; the benchmark is never recorded
+    std::unique_ptr<FrameRecorder> recorder;
+    if (!recordPath.empty() && !benchmark)
+    {
+        recorder = std::make_unique<FrameRecorder>(recordPath, recordFps);
+        if (!recorder->valid())
+            recorder.reset();
+    }
+
+    // Quality tiers replace the fixed scale and step counts; the benchmark keeps its sweep
+    std::unique_ptr<QualityGovernor> governor;
+    auto applyQualityTier = [&]() {
+        const QualityGovernor::Tier& tier = governor->tier();
+        frames.setRenderScale(tier.renderScale);
+        marchSteps = tier.marchSteps;
+        shadowSteps = tier.shadowSteps;
+        uploader.setMarchSteps(marchSteps, shadowSteps);
+        frames.resetHistory();
+        std::cout << "Quality: " << governor->describe() << std::endl;
+        // The governor moves one tier at a time
+        if (specialize)
+        {
+            std::vector<Shader::Defines> neighbours;
+            for (int t : { governor->tierIndex() - 1, governor->tierIndex() + 1 })
+            {
+                if (t < 0 || t >= (int)QualityGovernor::tiers().size())
+                    continue;
+                const QualityGovernor::Tier& other = QualityGovernor::tiers()[t];
+                neighbours.push_back(cloudDefines(useNoiseVolume, useSdfVolume, useLightVolume, marchMode,
+                                                  other.marchSteps, other.shadowSteps));
+            }
+            cloudVariants.prewarm(neighbours);
+        }
+    };
+    if (budgetMs > 0.0f && !benchmark)
+    {
+        governor = std::make_unique<QualityGovernor>(budgetMs);
+        applyQualityTier();
+    }
+
+    // The starting variant is built with the other startup programs; the rest compile in the background
+    if (specialize)
+    {
+        cloudVariants.require(currentCloudDefines());
+        prewarmCloudVariants();
+    }
+
+    // Offline runs step the scene at fixed times; interactively it updates on its own thread
+    bool offline = benchmark || recorder;
+    SceneState initialState;
+    initialState.time = offline ? 0.0 : glfwGetTime();
+    initialState.camera = camera;
+    initialState.lightDir = lightDir;
+    SceneUpdater sceneUpdater(initialState);
+    if (!offline)
+        sceneUpdater.start();
+
+    // The animation starts from the generated spheres and keeps the BVH topology built
+    // for them; each tick refits the tree and the bounding sphere around the new spheres
+    CloudAnimation animation;
+    std::vector<Sphere> animatedSpheres;
+    double animationTick = -1.0;
+    // The next distance volume is baked from a copy of the tree taken when it starts and
+    // replaces `sdf` once its last slice is done
+    SdfVolume pendingSdf;
+    SphereBVH bakeSource;
+    bool sdfBaking = false;
+    double sdfBakeTime = -1e9;
+    const int sdfSlicesPerTick = (sdfResolution + kSdfBakeTicks - 1) / kSdfBakeTicks;
+    // How far a surface can move from the start of one bake until the next one is shown:
+    // the rebake interval, the tick that lands just after it and the ticks of the bake itself
+    float sdfStaleness = 0.0f;
+    if (animate && benchmark)
+    {
+        std::cout << "The benchmark renders static clouds; --animate is ignored" << std::endl;
+    }
+    else if (animate)
+    {
+        animation = CloudAnimation(spheres, seed);
+        sdfStaleness = animation.maxSurfaceSpeed() * (float)(kSdfRebakeInterval + (kSdfBakeTicks + 1) / kAnimationRate);
+        // From the first tick on the static bake lags behind the spheres as well
+        uploader.uploadSdfVolume(sdf, sdfStaleness);
+    }
+    double lastReport = initialState.time;
     while(!glfwWindowShouldClose(window))
     {
-        // Update viewport size
+        profiler.beginFrame();
+        if (governor && governor->update(profiler.lastGpuFrameMs()))
+            applyQualityTier();
+
         int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        if (benchmark)
+        {
+            if (benchmark->done())
+                break;
+            const Benchmark::Config& config = benchmark->config();
+            if (benchmark->configStarting())
+            {
+                if (config.spheres != (int)spheres.size())
+                {
+                    buildScene(config.spheres);
+                    uploader.uploadScene(bvh, bounding);
+                    uploader.uploadSdfVolume(sdf);
+                    placeClouds();
+                    sceneUpdater.reset({ 0.0, camera, lightDir });
+                }
+                marchSteps = config.marchSteps;
+                shadowSteps = config.shadowSteps;
+                uploader.setMarchSteps(marchSteps, shadowSteps);
+                frames.resetHistory();
+            }
+            width = config.width;
+            height = config.height;
+            benchmark->beginFrame();
+            frames.setOutputFramebuffer(benchmark->framebuffer());
+        }
+        else
+        {
+            // Update viewport size
+            glfwGetFramebufferSize(window, &width, &height);
+        }
         glViewport(0, 0, width, height);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        shader.use();
+        // Swap in shaders that finished rebuilding since the last frame
+        {
+            Profiler::CpuScope scope(profiler, "shader reload");
+            reloader->update();
+        }
+
+        // The benchmark renders every frame at the same time so the noise and the light
+        // volume stay put; a recording steps the clock by one video frame
+        if (offline)
+            sceneUpdater.step(benchmark ? 0.0 : (double)recorder->frameCount() / recorder->fps());
+        // Interactively the newest update is carried forward to this frame's own clock, so
+        // consecutive frames advance by their real spacing, not by 4 or 5 whole update ticks
+        const SceneState& latest = sceneUpdater.latest();
+        const SceneState state = offline ? latest : latest.at(std::max(glfwGetTime(), latest.time));
+        double now = state.time;
+
+        // Any change to what is rendered invalidates the temporal history
+        bool settingsChanged = false;
+        if (noiseToggle.pressed(window))
+        {
+            useNoiseVolume = !useNoiseVolume;
+            settingsChanged = true;
+        }
+        if (sdfToggle.pressed(window))
+        {
+            useSdfVolume = !useSdfVolume;
+            settingsChanged = true;
+        }
+        if (marchToggle.pressed(window))
+        {
+            marchMode = marchMode == kMarchFixed ? kMarchAdaptive : kMarchFixed;
+            settingsChanged = true;
+            std::cout << "March mode: " << marchModeName(marchMode) << std::endl;
+        }
+        if (lightToggle.pressed(window))
+        {
+            useLightVolume = !useLightVolume;
+            settingsChanged = true;
+        }
+        if (state.lightDir != lightDir)
+        {
+            lightDir = state.lightDir;
+            uploader.setLightDirection(lightDir);
+            settingsChanged = true;
+        }
+        if (state.camera != camera)
+        {
+            camera = state.camera;
+            frames.resetHistory();
+        }
+        if (temporalToggle.pressed(window))
+        {
+            frames.setTemporalCell(frames.temporalCell() == 1 ? 2 : frames.temporalCell() == 2 ? 4 : 1);
+            std::cout << "Temporal mode: 1/" << frames.temporalCell() * frames.temporalCell()
+                      << " of the pixels per frame" << std::endl;
+        }
+        if (computeToggle.pressed(window))
+        {
+            useCompute = !useCompute;
+            printCloudPass();
+        }
+        if (settingsChanged)
+        {
+            applySettings();
+            prewarmCloudVariants();
+            frames.resetHistory();
+        }
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        // The spheres only change on a tick; the frames in between re-upload nothing new
+        if (!animation.empty())
+        {
+            Profiler::CpuScope scope(profiler, "cloud animation");
+            double tick = std::floor(now * kAnimationRate) / kAnimationRate;
+            if (tick != animationTick)
+            {
+                animationTick = tick;
+                animation.evaluate(tick, animatedSpheres);
+                bvh.refit(animatedSpheres);
+                bounding = bvh.boundingSphere();
+                clouds.setCloudBounds(bounding);
+                // Nothing in the history is where it was drawn any more
+                frames.resetHistory();
+                // The shown volume lags behind the spheres by at most sdfStaleness; the shader
+                // only skips space with it and takes inside tests from the refit tree
+                if (!sdfBaking && std::abs(tick - sdfBakeTime) >= kSdfRebakeInterval)
+                {
+                    sdfBakeTime = tick;
+                    bakeSource = bvh;
+                    sdfBaking = pendingSdf.beginBake(bakeSource, sdfResolution);
+                }
+                if (sdfBaking && pendingSdf.bakeSlices(bakeSource, sdfSlicesPerTick))
+                {
+                    std::swap(sdf, pendingSdf);
+                    uploader.uploadSdfVolume(sdf, sdfStaleness);
+                    sdfBaking = false;
+                }
+            }
+        }
 
-        glfwSwapBuffers(window);
+        // Only the per-frame values are written; scene data stays resident.
+        // The cloud is marched at the pipeline's render size, which is what iResolution holds.
+        {
+            Profiler::CpuScope scope(profiler, "frame upload");
+            frames.setFramebufferSize(width, height);
+            clouds.update(camera);
+            uploader.setCamera(camera);
+            uploader.beginFrame((float)now, frames.renderWidth(), frames.renderHeight());
+            if (!animation.empty())
+                uploader.updateScene(bvh, bounding);
+            uploader.bindTextures();
+        }
+
+        if (useLightVolume)
+        {
+            Profiler::GpuScope scope(profiler, "light volume");
+            LightVolume::Inputs lightInputs;
+            lightInputs.lightDir = lightDir;
+            lightInputs.sceneHash = sdf.hash();
+            lightInputs.useNoiseVolume = useNoiseVolume;
+            lightInputs.useSdfVolume = useSdfVolume;
+            lightInputs.shadowSteps = shadowSteps;
+            lightInputs.time = (float)now;
+            lightVolume.update(lightInputs);
+            lightVolume.bindTexture(SceneUploader::kLightVolumeUnit);
+        }
+
+        // Both paths write the same pixels, so the history carries over when switching
+        Shader* computeProgram = useCompute ? computeMarcher.activeProgram() : nullptr;
+        // Offline runs wait for the variant so that every frame uses the same program
+        Shader* variant = nullptr;
+        if (specialize && !computeProgram)
+        {
+            Profiler::CpuScope scope(profiler, "shader variants");
+            cloudVariants.update();
+            variant = offline ? cloudVariants.require(currentCloudDefines()) : cloudVariants.find(currentCloudDefines());
+        }
+        Shader& cloudProgram = computeProgram ? *computeProgram : variant ? *variant : *shader;
+        {
+            Profiler::GpuScope scope(profiler, "cloud pass");
+            cloudProgram.use();
+            frames.beginCloudPass(cloudProgram);
+            if (computeProgram)
+            {
+                computeMarcher.draw();
+            }
+            else
+            {
+                clouds.draw(cloudProgram);
+            }
+        }
+        {
+            Profiler::GpuScope scope(profiler, "resolve + present");
+            frames.endCloudPass();
+        }
+        uploader.endFrame();
+
+        if (benchmark)
+        {
+            benchmark->endFrame();
+        }
+        else
+        {
+            if (recorder)
+            {
+                Profiler::CpuScope scope(profiler, "capture");
+                recorder->capture(0, width, height);
+            }
+            Profiler::CpuScope scope(profiler, "swap");
+            glfwSwapBuffers(window);
+        }
+        if (!benchmark)
+        {
+            Profiler::CpuScope scope(profiler, "frame cap");
+            scheduler.waitForNextFrame();
+        }
         glfwPollEvents();
+        // Held keys are sampled here, on the main thread as GLFW requires, and applied by the updater
+        sceneUpdater.setInput(
+            (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS),
+            (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS),
+            (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS));
+
+        // Percentiles over the last Profiler::kHistoryFrames frames, every two seconds
+        if (profiler.enabled() && now - lastReport >= 2.0)
+        {
+            lastReport = now;
+            profiler.report(std::cout);
+            std::string title = "Cloud Ray Marching | " + profiler.summary();
+            if (governor)
+            {
+                std::cout << "Quality: " << governor->describe() << std::endl;
+                title += " | tier " + std::to_string(governor->tierIndex() + 1);
+            }
+            glfwSetWindowTitle(window, title.c_str());
+        }
     }
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    sceneUpdater.stop();
+    if (recorder)
+        recorder->finish();
+    if (benchmark && benchmark->writeCsv())
+        std::cout << "Benchmark results written to " << benchOptions.csvPath << std::endl;
+    if (profile)
+    {
+        profiler.report(std::cout);
+        if (profiler.writeChromeTrace(tracePath))
+            std::cout << "Profile trace written to " << tracePath << std::endl;
+    }
+
+    // Stop the watcher before its context goes away
+    reloader.reset();
+    if (reloadContext)
+        glfwDestroyWindow(reloadContext);
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
     return 0;
 }